@@ -19,8 +19,19 @@
 #define __CBOR_H__
 
 #include "cborg/CborBase.h"
+#include "cborg/CborArena.h"
 #include "cborg/Cbore.h"
+#include "cborg/CboreSink.h"
+#include "cborg/CboreStencil.h"
 #include "cborg/Cborg.h"
+#include "cborg/CborgIndex.h"
+#include "cborg/CborgPath.h"
+#include "cborg/CborgCursor.h"
+#include "cborg/CborgSax.h"
+#include "cborg/CborgStream.h"
+#include "cborg/CborgScatter.h"
+#include "cborg/CborgFloat.h"
+#include "cborg/CborgTyped.h"
 
 typedef CborBase Cbor;
 
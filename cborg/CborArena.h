@@ -0,0 +1,206 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __CBOR_ARENA_H__
+#define __CBOR_ARENA_H__
+
+#include <stdint.h>
+#include <cstddef>
+#include <type_traits>
+
+#include "cborg/CborBase.h"
+
+class Cbore;
+class CborArena;
+
+/*
+    Node of a mutable document, created by CborArena.
+
+    The value is a tagged union: the major and minor type from CborBase
+    select between an integer argument or float bits, a string, and the
+    children of a container. Maps keep their keys and values as pairs.
+    Nodes are never destroyed one by one, see CborArena::reset().
+*/
+class CborNode : public CborBase
+{
+public:
+    /*************************************************************************/
+    /* Container                                                             */
+    /*************************************************************************/
+
+    // items of an array, pairs of a map
+    virtual uint32_t getSize() const;
+
+    virtual CborBase* at(std::size_t index);
+    virtual CborBase* key(std::size_t index);
+    virtual CborBase* value(std::size_t index);
+
+    // first value with a text string key, NULL if not found
+    CborNode* find(const char* key, std::size_t length);
+
+    template <std::size_t I>
+    CborNode* find(const char (&key)[I])
+    {
+        return find(key, I - 1);
+    }
+
+    /*************************************************************************/
+    /* Values                                                                */
+    /*************************************************************************/
+
+    // each returns false if the node has a different type or the value does
+    // not fit in the result
+    bool getUnsigned(uint64_t* result) const;
+    bool getInteger(int64_t* result) const;
+    bool getDouble(double* result) const;
+    bool getBytes(const uint8_t** pointer, uint32_t* length) const;
+    bool getString(const char** pointer, uint32_t* length) const;
+
+    /*************************************************************************/
+    /* Encode                                                                */
+    /*************************************************************************/
+
+    // node and everything nested in it, false if nested deeper than
+    // CBORG_MAX_DEPTH; check Cbore::hasOverflow() for dropped items
+    bool encode(Cbore& encoder) const;
+
+    virtual uint32_t writeCBOR(uint8_t* destination, uint32_t maxLength);
+
+    /*************************************************************************/
+    /* Debug                                                                 */
+    /*************************************************************************/
+
+    virtual void print();
+
+private:
+    friend class CborArena;
+
+    CborNode(MajorType_t _majorType, SimpleType_t _minorType);
+
+    // tag and item, containers only their header
+    void encodeHead(Cbore& encoder) const;
+
+    union {
+        uint64_t argument;      // integers and simple values, bits of floats
+
+        struct {
+            const uint8_t* data;
+            uint32_t length;
+        } string;
+
+        struct {
+            CborNode** items;   // key, value, key, ... for maps
+            uint32_t count;
+            uint32_t capacity;
+        } container;
+    } content;
+};
+
+/*
+    Bump allocator for CborNode trees in a caller supplied buffer.
+
+    Nodes can be created and attached in any order, so documents that are
+    not built front to back do not need the fluent encoder. Nothing is
+    freed on its own, reset() drops the whole document at once:
+
+        uint8_t storage[2048];
+        CborArena arena(storage, sizeof(storage));
+
+        CborNode* root = arena.map();
+        CborNode* readings = arena.array();
+
+        arena.insert(root, arena.string("readings"), readings);
+        arena.append(readings, arena.integer(-12));
+        arena.insert(root, arena.string("id"), arena.integer(7));
+
+        root->writeCBOR(buffer, sizeof(buffer));
+        arena.reset();
+
+    Factories return NULL when the buffer is full, append() and insert()
+    return false for NULL nodes, so a chain of calls fails safely.
+*/
+class CborArena
+{
+public:
+    CborArena(uint8_t* buffer, std::size_t size);
+
+    // drop every node, takes constant time
+    void reset();
+
+    std::size_t getUsed() const;
+    std::size_t getCapacity() const;
+
+    /*************************************************************************/
+    /* Factories                                                             */
+    /*************************************************************************/
+
+    // room for items or pairs is reserved up front, containers grow as needed
+    CborNode* array(std::size_t items = 0);
+    CborNode* map(std::size_t pairs = 0);
+
+    // any signed or unsigned type up to 64 bits
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, CborNode*>::type integer(T value)
+    {
+        if (std::is_signed<T>::value && ((int64_t) value < 0))
+        {
+            return createInteger(true, (uint64_t) (-1 - (int64_t) value));
+        }
+
+        return createInteger(false, (uint64_t) value);
+    }
+
+    // false, true, null, undefined or an unassigned value below 20,
+    // NULL for anything else
+    CborNode* simple(CborBase::SimpleType_t value);
+
+    CborNode* floating(float value);
+    CborNode* floating(double value);
+
+    // strings are copied into the arena
+    CborNode* string(const char* text, std::size_t length);
+    CborNode* bytes(const uint8_t* data, std::size_t length);
+
+    template <std::size_t I>
+    CborNode* string(const char (&text)[I])
+    {
+        return string(text, I - 1);
+    }
+
+    /*************************************************************************/
+    /* Mutators                                                              */
+    /*************************************************************************/
+
+    bool append(CborNode* array, CborNode* item);
+    bool insert(CborNode* map, CborNode* key, CborNode* value);
+
+    // replace an item of an array or a value of a map
+    bool replace(CborNode* container, std::size_t index, CborNode* item);
+
+private:
+    void* allocate(std::size_t size, std::size_t alignment);
+    CborNode* create(CborBase::MajorType_t majorType, CborBase::SimpleType_t minorType);
+    CborNode* createInteger(bool negative, uint64_t argument);
+    CborNode* createContainer(CborBase::MajorType_t majorType, std::size_t units);
+    bool grow(CborNode* container, std::size_t units);
+
+    uint8_t* buffer;
+    std::size_t size;
+    std::size_t used;
+};
+
+#endif // __CBOR_ARENA_H__
@@ -19,57 +19,175 @@
 
 #include <stdint.h>
 #include <cstddef>
+#include <type_traits>
+#include <array>
+#include <string.h>
 
 #include "cborg/CborgHeader.h"
+#include "cborg/CborgStack.h"
+#include "cborg/CborgTyped.h"
+#include "cborg/CboreConstant.h"
+#include "cborg/CboreSink.h"
 #include "cborg/CborBase.h"
 
+class Cborg;
 
+/*
+    Encoder with a fluent interface.
+
+    Items are written into a fixed buffer, or into windows provided by a
+    CboreSink. With a fixed buffer, items that do not fit are dropped. With
+    a sink, the document can be larger than any window: the sink is asked
+    for more room when a window is full and strings are split across
+    windows. Call flush() at the end to pass the rest on to the sink.
+*/
 class Cbore
 {
 public:
+    typedef enum {
+        FloatAsGiven    = 0x00,     // float as single, double as double precision
+        FloatShortest   = 0x01      // shortest of half, single and double that keeps the value
+    } FloatMode_t;
+
+    /*
+        array() and map() without a count either start an indefinite
+        container, or reserve a three byte header that end() fills in with
+        the number of items. Patched containers must stay in the current
+        window until end(), which is always the case for fixed buffers and
+        the vector sink; other sinks pass on everything before them.
+
+        The three byte header is reserved in both patched modes, so while a
+        compact container is open it needs two bytes more room than its
+        final encoding. A fixed buffer that only fits the final encoding
+        overflows, e.g., array().item(1).end() in two bytes.
+    */
+    typedef enum {
+        ContainerIndefinite = 0x00,     // end() writes a break
+        ContainerPatch      = 0x01,     // nothing moves unless the count needs more than two bytes
+        ContainerCompact    = 0x02      // header shrunk to the shortest form, contents move down
+    } ContainerMode_t;
+
+    // fixed width items written by slot(), see CboreStencil
+    typedef enum {
+        SlotInteger32   = 0x00,     // integer with four byte argument
+        SlotInteger64   = 0x01,     // integer with eight byte argument
+        SlotFloat       = 0x02,     // single precision regardless of the float mode
+        SlotDouble      = 0x03      // double precision regardless of the float mode
+    } SlotType_t;
+
     Cbore();
 
     Cbore(uint8_t* cbor, std::size_t maxLength);
 
+    Cbore(CboreSink& sink);
+
+    // total encoded length, including data already passed to the sink
     std::size_t getLength() const;
 
+    // pass the encoded data on to the sink, false if the sink failed
+    bool flush();
+
+    // true once an item has been dropped because the buffer was full, the
+    // sink failed or containers were nested too deep
+    bool hasOverflow() const;
+
+    /*
+        Document state to return to, e.g., to drop an optional section that
+        did not fit. rollback() restores the length, the open containers and
+        the overflow flag. It fails when bytes after the savepoint have
+        already been passed to the sink, or when a patched container that
+        was open at the savepoint has been closed since.
+    */
+    class Savepoint;
+
+    Savepoint savepoint() const;
+
+    bool rollback(const Savepoint& point);
+
+    void setFloatMode(FloatMode_t mode);
+
+    void setContainerMode(ContainerMode_t mode);
+
     /* Encode methods */
     Cbore& tag(uint32_t tag);
 
-    // end indefinite map/array
+    // end indefinite or patched map/array
     Cbore& end();
 
+    // write pre-encoded bytes from CboreConstant::encode(), counted as items
+    // when inside a patched container
+    template <std::size_t N>
+    Cbore& constant(const std::array<uint8_t, N>& encoded, std::size_t items = 1)
+    {
+        if ((N > (maxLength - currentLength)) || (levels.size() > 0))
+        {
+            return writeRaw(encoded.data(), N, items, false);
+        }
+
+        memcpy(&cbor[currentLength], encoded.data(), N);
+        currentLength += N;
+
+        return *this;
+    }
+
+    // write already encoded items as they are, counted as items when inside a
+    // patched container. The bytes are not checked. Sinks may keep a pointer
+    // to long runs like they do for strings, so they must stay valid until
+    // the document is flushed.
+    Cbore& raw(const uint8_t* encoded, std::size_t length, std::size_t items = 1);
+
+    // write the item the decoder points to, including everything nested in
+    // it, with a single copy and without decoding it
+    Cbore& raw(const Cborg& subtree);
+
+    // write fixed width item with value zero, as item, key or value, offset
+    // is set to its position in the document so the value can be stored later
+    Cbore& slot(SlotType_t type, std::size_t* offset);
+
     /*************************************************************************/
     /* Array creation                                                        */
     /*************************************************************************/
 
-    // create indefinite map
+    // create indefinite or patched array, see ContainerMode_t
     Cbore& array();
 
     // create array with size
     Cbore& array(std::size_t items);
 
+    // write array of floats, precision depends on the float mode
+    Cbore& array(const float* values, std::size_t count);
+
+    // write RFC 8746 typed array in host byte order, the values are copied
+    // as they are into a single tagged byte string
+    template <typename T>
+    Cbore& typedArray(const T* values, std::size_t count)
+    {
+        return writeTyped(CborgTyped::tag<T>(), values, count * sizeof(T));
+    }
+
     /*************************************************************************/
     /* Array insertion                                                       */
     /*************************************************************************/
 
-    // write <integer>
-    Cbore& item(int32_t value);
+    // write <integer>, any signed or unsigned type up to 64 bits
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, Cbore&>::type item(T value)
+    {
+        return writeInteger(isNegative(value), argument(value));
+    }
 
     // write <simple type>
     Cbore& item(CborBase::SimpleType_t simpleType);
 
+    // write <float>, precision depends on the float mode
+    Cbore& item(float value);
+    Cbore& item(double value);
+
     // write <string>
     template <std::size_t I>
     Cbore& item(const char (&string)[I])
     {
-        if ((itemSize(I) + I) <= (maxLength - currentLength))
-        {
-            writeTypeAndValue(CborBase::TypeString, I - 1);
-            writeBytes((const uint8_t*) string, I - 1);
-        }
-
-        return *this;
+        return writeLiteral(string);
     }
 
     // write bytes, length
@@ -82,7 +200,7 @@ public:
     /* Map creation                                                          */
     /*************************************************************************/
 
-    // create indefinite map
+    // create indefinite or patched map, see ContainerMode_t
     Cbore& map();
 
     // create map with size
@@ -93,19 +211,17 @@ public:
     /*************************************************************************/
 
     // insert key as integer
-    Cbore& key(int32_t unit);
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, Cbore&>::type key(T unit)
+    {
+        return writeInteger(isNegative(unit), argument(unit));
+    }
 
     // insert key as const char array
     template <std::size_t I>
     Cbore& key(const char (&unit)[I])
     {
-        if ((itemSize(I) + I) <= (maxLength - currentLength))
-        {
-            writeTypeAndValue(CborBase::TypeString, I - 1);
-            writeBytes((const uint8_t*) unit, I - 1);
-        }
-
-        return *this;
+        return writeLiteral(unit);
     }
 
     // insert key as const char pointer with length
@@ -116,22 +232,24 @@ public:
     /*************************************************************************/
 
     // insert value as integer
-    Cbore& value(int32_t unit);
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, Cbore&>::type value(T unit)
+    {
+        return writeInteger(isNegative(unit), argument(unit));
+    }
 
     // insert value as simple type
     Cbore& value(CborBase::SimpleType_t value);
 
+    // insert value as float
+    Cbore& value(float unit);
+    Cbore& value(double unit);
+
     // insert value as const char array
     template <std::size_t I>
     Cbore& value(const char (&unit)[I])
     {
-        if ((itemSize(I) + I) <= (maxLength - currentLength))
-        {
-            writeTypeAndValue(CborBase::TypeString, I - 1);
-            writeBytes((const uint8_t*) unit, I - 1);
-        }
-
-        return *this;
+        return writeLiteral(unit);
     }
 
     // insert value as byte array with length
@@ -143,6 +261,9 @@ public:
     /*************************************************************************/
     /* Reset                                                                 */
     /*************************************************************************/
+
+    // start over, with a sink the current window is dropped without
+    // passing it on
     Cbore& reset(bool resetBuffer);
 
     /*************************************************************************/
@@ -153,14 +274,140 @@ public:
     void print() const;
 
 private:
-    uint8_t itemSize(int32_t item);
-    uint8_t writeTypeAndValue(CborBase::MajorType_t majorType, uint32_t value);
-    uint32_t writeBytes(const uint8_t* source, uint32_t length);
+    template <typename T>
+    static bool isNegative(T value)
+    {
+        return std::is_signed<T>::value && ((int64_t) value < 0);
+    }
+
+    // argument of the encoded integer, -1 - value for negative integers
+    template <typename T>
+    static uint64_t argument(T value)
+    {
+        return isNegative(value) ? (uint64_t) (-1 - (int64_t) value) : (uint64_t) value;
+    }
+
+    Cbore& writeInteger(bool negative, uint64_t argument);
+    Cbore& writeFloat(uint8_t simpleType, uint64_t bits);
+    Cbore& writeTyped(uint32_t tag, const void* values, std::size_t length);
+    Cbore& writeString(CborBase::MajorType_t majorType, const uint8_t* source, std::size_t length);
+    Cbore& writeRaw(const uint8_t* encoded, std::size_t length, std::size_t items, bool byReference);
+
+    // string literal, the header is known at compile time
+    template <std::size_t I>
+    Cbore& writeLiteral(const char (&string)[I])
+    {
+        static const std::size_t header = CboreSize::header(I - 1);
+
+        if ((header + I - 1 > (maxLength - currentLength)) || (I - 1 >= referenceLength) || (levels.size() > 0))
+        {
+            return writeString(CborBase::TypeString, (const uint8_t*) string, I - 1);
+        }
+
+        uint8_t* pointer = &cbor[currentLength];
+
+        for (std::size_t idx = 0; idx < header; idx++)
+        {
+            pointer[idx] = CboreSize::headerByte(CborBase::TypeString, I - 1, idx);
+        }
+
+        memcpy(&pointer[header], string, I - 1);
+        currentLength += header + I - 1;
+
+        return *this;
+    }
+
+    // room for required bytes in the current window
+    bool reserve(std::size_t required)
+    {
+        return (required <= (maxLength - currentLength)) || grow(required);
+    }
+
+    // room for a header and its payload, with a sink only the header has
+    // to fit in the window since the payload can be split
+    bool fits(std::size_t header, uint64_t payload)
+    {
+        if ((payload <= (maxLength - currentLength)) && (header <= (maxLength - currentLength - payload)))
+        {
+            return true;
+        }
+
+        if (sink == NULL)
+        {
+            overflow = true;
+
+            return false;
+        }
+
+        return reserve(header);
+    }
+
+    bool grow(std::size_t required);
+    bool refill(std::size_t required);
+
+    std::size_t kept() const;
+    Cbore& counted();
+    void begin();
+    void closeDefinite();
+    Cbore& openContainer(CborBase::MajorType_t majorType);
+    Cbore& openDefinite(CborBase::MajorType_t majorType, std::size_t items);
+    Cbore& closeContainer();
+    Cbore& refillInteger(bool negative, uint64_t argument, std::size_t required);
+    Cbore& refillFloat(uint8_t simpleType, uint64_t bits, std::size_t required);
+    uint8_t refillTypeAndValue(CborBase::MajorType_t majorType, uint64_t value, std::size_t required);
+    std::size_t writeSplit(const uint8_t* source, std::size_t length, bool byReference = true);
+
+    uint8_t itemSize(uint64_t argument);
+    uint8_t writeTypeAndValue(CborBase::MajorType_t majorType, uint64_t value);
+    std::size_t writeBytes(const uint8_t* source, std::size_t length);
 
 private:
     uint8_t* cbor;
     std::size_t currentLength;
     std::size_t maxLength;
+    FloatMode_t floatMode;
+
+    // output beyond the current window
+    CboreSink* sink;
+    std::size_t flushed;
+
+    // payloads this long are passed to the sink by reference
+    std::size_t referenceLength;
+
+    // an item has been dropped
+    bool overflow;
+
+    typedef enum {
+        LevelDefinite   = 0x00,
+        LevelIndefinite = 0x01,
+        LevelPatch      = 0x02,
+        LevelCompact    = 0x03
+    } LevelMode_t;
+
+    typedef struct {
+        std::size_t position;       // header offset from the start of the document
+        std::size_t units;          // items so far, remaining for definite containers
+        uint8_t majorType;
+        uint8_t mode;
+    } Level_t;
+
+    // open containers from the outermost patched one inwards
+    CborgStack<Level_t> levels;
+    ContainerMode_t containerMode;
+};
+
+/*
+    Copy of the encoder state, the open containers are kept inline so
+    taking a savepoint never allocates.
+*/
+class Cbore::Savepoint
+{
+private:
+    friend class Cbore;
+
+    std::size_t length;
+    CborgStack<Cbore::Level_t> levels;
+    bool overflow;
 };
 
 #endif // __CBORE_H__
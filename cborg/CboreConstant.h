@@ -0,0 +1,289 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __CBORE_CONSTANT_H__
+#define __CBORE_CONSTANT_H__
+
+#include <stdint.h>
+#include <cstddef>
+#include <array>
+
+#include "cborg/CborBase.h"
+
+/*
+    Encoded sizes as constant expressions, for sizing buffers of fixed
+    schemas at compile time:
+
+        static const std::size_t bound = CboreSize::header(2)
+            + CboreSize::literal("id") + CboreSize::integer(UINT32_MAX)
+            + CboreSize::literal("samples") + CboreSize::typedArray<int16_t>(64);
+
+        uint8_t buffer[bound];
+
+    Patched containers take three bytes until they hold more than 65535
+    items, indefinite ones one byte plus one for the break.
+*/
+class CboreSize
+{
+public:
+    // header with argument, also the size of array and map headers
+    static constexpr std::size_t header(uint64_t argument)
+    {
+        return (argument <= 23) ? 1
+             : (argument <= 0xFF) ? 2
+             : (argument <= 0xFFFF) ? 3
+             : (argument <= 0xFFFFFFFF) ? 5 : 9;
+    }
+
+    // largest encoding of any value up to the given magnitude
+    static constexpr std::size_t integer(int64_t value)
+    {
+        return header((value < 0) ? (uint64_t) (-1 - value) : (uint64_t) value);
+    }
+
+    static constexpr std::size_t string(std::size_t length)
+    {
+        return header(length) + length;
+    }
+
+    template <std::size_t I>
+    static constexpr std::size_t literal(const char (&)[I])
+    {
+        return string(I - 1);
+    }
+
+    static constexpr std::size_t singleFloat()
+    {
+        return 5;
+    }
+
+    static constexpr std::size_t doubleFloat()
+    {
+        return 9;
+    }
+
+    // RFC 8746 tags are 64 to 87 and take two bytes
+    template <typename T>
+    static constexpr std::size_t typedArray(std::size_t count)
+    {
+        return 2 + string(count * sizeof(T));
+    }
+
+    // byte at index of a header with argument
+    static constexpr uint8_t headerByte(uint8_t majorType, uint64_t argument, std::size_t index)
+    {
+        return (index == 0)
+            ? (uint8_t) ((majorType << 5) | ((argument <= 23) ? argument
+                                           : (argument <= 0xFF) ? 24
+                                           : (argument <= 0xFFFF) ? 25
+                                           : (argument <= 0xFFFFFFFF) ? 26 : 27))
+            : (uint8_t) (argument >> (8 * (header(argument) - 1 - index)));
+    }
+};
+
+/*
+    Fragments of constant items, combined with CboreConstant::join() and
+    turned into bytes by CboreConstant::encode(). Each has its encoded
+    length and the byte at an index as constant expressions.
+*/
+template <uint8_t MajorType, uint64_t Argument>
+class CboreConstantHeader
+{
+public:
+    static const std::size_t length = CboreSize::header(Argument);
+
+    constexpr uint8_t at(std::size_t index) const
+    {
+        return CboreSize::headerByte(MajorType, Argument, index);
+    }
+};
+
+template <uint8_t MajorType, typename T, std::size_t L>
+class CboreConstantString
+{
+public:
+    static const std::size_t length = CboreSize::string(L);
+
+    constexpr CboreConstantString(const T* _data)
+        :   data(_data)
+    {}
+
+    constexpr uint8_t at(std::size_t index) const
+    {
+        return (index < CboreSize::header(L)) ? CboreSize::headerByte(MajorType, L, index)
+                                              : (uint8_t) data[index - CboreSize::header(L)];
+    }
+
+private:
+    const T* data;
+};
+
+template <typename F, typename G>
+class CboreConstantPair
+{
+public:
+    static const std::size_t length = F::length + G::length;
+
+    constexpr CboreConstantPair(const F& _first, const G& _second)
+        :   first(_first),
+            second(_second)
+    {}
+
+    constexpr uint8_t at(std::size_t index) const
+    {
+        return (index < F::length) ? first.at(index) : second.at(index - F::length);
+    }
+
+private:
+    F first;
+    G second;
+};
+
+// type of fragments joined one after the other
+template <typename... F>
+struct CboreConstantJoined;
+
+template <typename F>
+struct CboreConstantJoined<F>
+{
+    typedef F type;
+};
+
+template <typename F, typename... R>
+struct CboreConstantJoined<F, R...>
+{
+    typedef CboreConstantPair<F, typename CboreConstantJoined<R...>::type> type;
+};
+
+// 0 to N - 1 as a parameter pack, built in log N steps
+template <std::size_t... I>
+struct CboreConstantIndexList
+{
+    typedef CboreConstantIndexList type;
+};
+
+template <typename A, typename B>
+struct CboreConstantConcat;
+
+template <std::size_t... I, std::size_t... J>
+struct CboreConstantConcat<CboreConstantIndexList<I...>, CboreConstantIndexList<J...> >
+    : CboreConstantIndexList<I..., (sizeof...(I) + J)...>
+{};
+
+template <std::size_t N>
+struct CboreConstantIndices
+    : CboreConstantConcat<typename CboreConstantIndices<N / 2>::type, typename CboreConstantIndices<N - N / 2>::type>
+{};
+
+template <>
+struct CboreConstantIndices<0> : CboreConstantIndexList<>
+{};
+
+template <>
+struct CboreConstantIndices<1> : CboreConstantIndexList<0>
+{};
+
+/*
+    Compile-time encoding of constant items and sub-documents:
+
+        static constexpr auto unit = CboreConstant::encode(
+            CboreConstant::join(CboreConstant::string("unit"), CboreConstant::string("C")));
+
+        encoder.map(2).constant(unit, 2).key("value").value(reading);
+
+    Floats are left out, their bit patterns are not constant expressions
+    before C++20.
+*/
+class CboreConstant
+{
+public:
+    template <int64_t Value>
+    static constexpr CboreConstantHeader<(Value < 0) ? CborBase::TypeNegative : CborBase::TypeUnsigned,
+                                         (Value < 0) ? (uint64_t) (-1 - Value) : (uint64_t) Value> integer()
+    {
+        return CboreConstantHeader<(Value < 0) ? CborBase::TypeNegative : CborBase::TypeUnsigned,
+                                   (Value < 0) ? (uint64_t) (-1 - Value) : (uint64_t) Value>();
+    }
+
+    template <CborBase::SimpleType_t Simple>
+    static constexpr CboreConstantHeader<CborBase::TypeSpecial, Simple> simple()
+    {
+        return CboreConstantHeader<CborBase::TypeSpecial, Simple>();
+    }
+
+    template <uint32_t Tag>
+    static constexpr CboreConstantHeader<CborBase::TypeTag, Tag> tag()
+    {
+        return CboreConstantHeader<CborBase::TypeTag, Tag>();
+    }
+
+    // header of a definite array, the items follow
+    template <std::size_t Items>
+    static constexpr CboreConstantHeader<CborBase::TypeArray, Items> array()
+    {
+        return CboreConstantHeader<CborBase::TypeArray, Items>();
+    }
+
+    // header of a definite map, the pairs follow
+    template <std::size_t Pairs>
+    static constexpr CboreConstantHeader<CborBase::TypeMap, Pairs> map()
+    {
+        return CboreConstantHeader<CborBase::TypeMap, Pairs>();
+    }
+
+    // text string from a literal, without the terminating zero
+    template <std::size_t I>
+    static constexpr CboreConstantString<CborBase::TypeString, char, I - 1> string(const char (&text)[I])
+    {
+        return CboreConstantString<CborBase::TypeString, char, I - 1>(text);
+    }
+
+    // byte string from a constant array
+    template <std::size_t I>
+    static constexpr CboreConstantString<CborBase::TypeBytes, uint8_t, I> bytes(const uint8_t (&data)[I])
+    {
+        return CboreConstantString<CborBase::TypeBytes, uint8_t, I>(data);
+    }
+
+    // fragments one after the other
+    template <typename F>
+    static constexpr F join(const F& fragment)
+    {
+        return fragment;
+    }
+
+    template <typename F, typename G, typename... R>
+    static constexpr typename CboreConstantJoined<F, G, R...>::type join(const F& first, const G& second, const R&... rest)
+    {
+        return typename CboreConstantJoined<F, G, R...>::type(first, join(second, rest...));
+    }
+
+    template <typename F>
+    static constexpr std::array<uint8_t, F::length> encode(const F& fragment)
+    {
+        return expand(fragment, typename CboreConstantIndices<F::length>::type());
+    }
+
+private:
+    template <typename F, std::size_t... I>
+    static constexpr std::array<uint8_t, F::length> expand(const F& fragment, CboreConstantIndexList<I...>)
+    {
+        return {{ fragment.at(I)... }};
+    }
+};
+
+#endif // __CBORE_CONSTANT_H__
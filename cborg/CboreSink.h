@@ -0,0 +1,197 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __CBORE_SINK_H__
+#define __CBORE_SINK_H__
+
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+
+#include "cborg/CborgScatter.h"
+
+/*
+    Output for Cbore beyond a single fixed buffer.
+
+    The encoder writes into a window provided by the sink and only calls
+    next() when the window is full, so the common path is unchanged:
+
+        bool next(uint8_t** window, std::size_t* size, std::size_t* used,
+                  std::size_t required, std::size_t keep)
+
+    used bytes of the window hold encoded data and the encoder needs room
+    for required more. The sink either keeps the data and returns a larger
+    window, or takes the data and returns a window of its own size, which
+    may be smaller than required; used is set to the bytes still held in
+    the returned window. The last keep bytes
+    may still change (see Cbore::ContainerPatch) and must not be taken, they
+    are moved to the start of the new window. Headers must fit in one
+    window, payloads are split across windows.
+
+    Cbore::flush() calls next() with required set to zero to pass on the
+    rest of the document. Returns false when no room can be provided.
+
+    Sinks can also take payloads by reference instead of having them
+    copied into the window: strings of at least getReferenceLength() bytes
+    are passed to reference(), which takes the used part of the window
+    like next() and then records the payload pointer. Returning false
+    falls back to copying.
+
+    A sink that only counts may ignore keep: end() then adjusts the length
+    of patched containers without writing their headers.
+*/
+class CboreSink
+{
+public:
+    virtual ~CboreSink() {}
+
+    virtual bool next(uint8_t** window, std::size_t* size, std::size_t* used, std::size_t required, std::size_t keep) = 0;
+
+    // zero when payloads are always copied
+    virtual std::size_t getReferenceLength() const
+    {
+        return 0;
+    }
+
+    virtual bool reference(const uint8_t*, std::size_t, uint8_t**, std::size_t*, std::size_t*, std::size_t)
+    {
+        return false;
+    }
+};
+
+/*
+    Growable output, the vector holds the complete document after flush().
+*/
+class CboreVectorSink : public CboreSink
+{
+public:
+    CboreVectorSink(std::vector<uint8_t>& output);
+
+    virtual bool next(uint8_t** window, std::size_t* size, std::size_t* used, std::size_t required, std::size_t keep);
+
+private:
+    std::vector<uint8_t>& output;
+};
+
+/*
+    Chain of fixed-size blocks, e.g., for handing to a network stack.
+    Blocks must be large enough for the largest header (16 bytes); the
+    last block is trimmed to its used size by flush().
+*/
+class CboreBlockSink : public CboreSink
+{
+public:
+    CboreBlockSink(std::size_t blockSize);
+
+    virtual bool next(uint8_t** window, std::size_t* size, std::size_t* used, std::size_t required, std::size_t keep);
+
+    std::size_t getBlocks() const;
+    const std::vector<uint8_t>& getBlock(std::size_t index) const;
+
+    // drop all blocks, reset the encoder before writing again
+    void clear();
+
+private:
+    std::size_t blockSize;
+    std::vector<std::vector<uint8_t> > blocks;
+};
+
+/*
+    Bounded memory output through a single buffer, full buffers are passed
+    to the write function, e.g., to send them on a file descriptor.
+*/
+class CboreCallbackSink : public CboreSink
+{
+public:
+    typedef bool (*Write_t)(const uint8_t* data, std::size_t length, void* context);
+
+    CboreCallbackSink(uint8_t* buffer, std::size_t length, Write_t write, void* context = NULL);
+
+    virtual bool next(uint8_t** window, std::size_t* size, std::size_t* used, std::size_t required, std::size_t keep);
+
+private:
+    uint8_t* buffer;
+    std::size_t length;
+    Write_t write;
+    void* context;
+};
+
+/*
+    Gather list output: headers and small items are written to the buffer,
+    large payloads are only referenced. The resulting segments list the
+    document in order and can be copied into an iovec array for writev()
+    or sendmsg(), or decoded directly with CborgScatter.
+
+    Referenced payloads are not copied, they must stay valid and unchanged
+    until the segments have been used.
+*/
+class CboreGatherSink : public CboreSink
+{
+public:
+    CboreGatherSink(uint8_t* buffer, std::size_t length, std::size_t referenceLength = 256);
+
+    virtual bool next(uint8_t** window, std::size_t* size, std::size_t* used, std::size_t required, std::size_t keep);
+
+    virtual std::size_t getReferenceLength() const;
+
+    virtual bool reference(const uint8_t* data, std::size_t length,
+                           uint8_t** window, std::size_t* size, std::size_t* used, std::size_t keep);
+
+    // segments of the document, complete after Cbore::flush()
+    const CborgSegment* getSegments() const;
+    std::size_t getCount() const;
+
+    // drop all segments and reuse the buffer, reset the encoder as well
+    void clear();
+
+private:
+    void append(const uint8_t* data, std::size_t length);
+
+    uint8_t* buffer;
+    std::size_t length;
+    std::size_t offset;
+    std::size_t referenceLength;
+
+    std::vector<CborgSegment> segments;
+};
+
+/*
+    Measure only: items go to a small scratch window that is discarded,
+    long payloads are not even copied. Encoding into it gives the exact
+    size the same calls produce with a large enough buffer:
+
+        CboreCountSink counter;
+        Cbore encoder(counter);
+        ...
+        std::size_t size = encoder.getLength();
+*/
+class CboreCountSink : public CboreSink
+{
+public:
+    virtual bool next(uint8_t** window, std::size_t* size, std::size_t* used, std::size_t required, std::size_t keep);
+
+    virtual std::size_t getReferenceLength() const;
+
+    virtual bool reference(const uint8_t* data, std::size_t length,
+                           uint8_t** window, std::size_t* size, std::size_t* used, std::size_t keep);
+
+private:
+    // small items are written here, longer strings are dropped right away
+    uint8_t scratch[256];
+};
+
+#endif // __CBORE_SINK_H__
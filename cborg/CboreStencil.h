@@ -0,0 +1,144 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __CBORE_STENCIL_H__
+#define __CBORE_STENCIL_H__
+
+#include <stdint.h>
+#include <cstddef>
+#include <string.h>
+
+#include "cborg/CborBase.h"
+
+/*
+    Pre-encoded message with fixed width value slots.
+
+    The stencil is encoded once with Cbore, writing Cbore::slot() wherever a
+    value changes between messages. Each message is then a copy of the
+    stencil with the values stored big-endian straight into the slots:
+
+        std::size_t temperature, count;
+
+        Cbore encoder(storage, sizeof(storage));
+        encoder.map(3)
+                    .key("id").value(7)
+                    .key("temperature").slot(Cbore::SlotFloat, &temperature)
+                    .key("count").slot(Cbore::SlotInteger32, &count);
+
+        CboreStencil stencil(storage, encoder.getLength());
+
+        std::size_t length = stencil.copy(message, sizeof(message));
+        CboreStencil::setFloat(message, temperature, 21.5f);
+        CboreStencil::setUnsigned(message, count, 1234);
+
+    The setters do no checks, the offset must belong to a slot of the
+    matching type: setUnsigned() and setInteger() need SlotInteger32,
+    setUnsigned64() and setInteger64() SlotInteger64, setFloat() SlotFloat
+    and setDouble() SlotDouble.
+*/
+class CboreStencil
+{
+public:
+    CboreStencil(const uint8_t* _cbor, std::size_t _length)
+        :   cbor(_cbor),
+            length(_length)
+    {}
+
+    std::size_t getLength() const
+    {
+        return length;
+    }
+
+    // copy the stencil into message, returns its length or 0 if it does not fit
+    std::size_t copy(uint8_t* message, std::size_t maxLength) const
+    {
+        if ((message == NULL) || (length > maxLength))
+        {
+            return 0;
+        }
+
+        memcpy(message, cbor, length);
+
+        return length;
+    }
+
+    static void setUnsigned(uint8_t* message, std::size_t offset, uint32_t value)
+    {
+        message[offset] = CborBase::TypeUnsigned << 5 | 26;
+        store32(&message[offset + 1], value);
+    }
+
+    static void setInteger(uint8_t* message, std::size_t offset, int32_t value)
+    {
+        // negative integers store -1 - value, the major type changes with the sign
+        uint32_t sign = (value < 0) ? 0xFFFFFFFF : 0;
+
+        message[offset] = (CborBase::TypeUnsigned << 5 | 26) + (sign & (CborBase::TypeNegative << 5));
+        store32(&message[offset + 1], (uint32_t) value ^ sign);
+    }
+
+    static void setUnsigned64(uint8_t* message, std::size_t offset, uint64_t value)
+    {
+        message[offset] = CborBase::TypeUnsigned << 5 | 27;
+        store64(&message[offset + 1], value);
+    }
+
+    static void setInteger64(uint8_t* message, std::size_t offset, int64_t value)
+    {
+        uint64_t sign = (value < 0) ? 0xFFFFFFFFFFFFFFFFULL : 0;
+
+        message[offset] = (CborBase::TypeUnsigned << 5 | 27) + (sign & (CborBase::TypeNegative << 5));
+        store64(&message[offset + 1], (uint64_t) value ^ sign);
+    }
+
+    static void setFloat(uint8_t* message, std::size_t offset, float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+
+        store32(&message[offset + 1], bits);
+    }
+
+    static void setDouble(uint8_t* message, std::size_t offset, double value)
+    {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+
+        store64(&message[offset + 1], bits);
+    }
+
+private:
+    // byte stores, compilers merge them into a single swapped store
+    static void store32(uint8_t* pointer, uint32_t value)
+    {
+        pointer[0] = value >> 24;
+        pointer[1] = value >> 16;
+        pointer[2] = value >> 8;
+        pointer[3] = value;
+    }
+
+    static void store64(uint8_t* pointer, uint64_t value)
+    {
+        store32(pointer, value >> 32);
+        store32(&pointer[4], value);
+    }
+
+    const uint8_t* cbor;
+    std::size_t length;
+};
+
+#endif // __CBORE_STENCIL_H__
@@ -22,17 +22,84 @@
 #include <string>
 
 #include "cborg/CborgHeader.h"
+#include "cborg/CborgTyped.h"
 #include "cborg/CborBase.h"
 
+class CborgPath;
+class CborgIterator;
+class CborgPairIterator;
+
+template <typename Iterator>
+class CborgRange;
+
+/*
+    Map key used for looking up several values in one pass.
+    Keys are either integers or strings.
+*/
+class CborgKey
+{
+public:
+    CborgKey(int32_t key);
+    CborgKey(const char* key, std::size_t keyLength);
+
+    template <std::size_t I>
+    CborgKey(const char (&key)[I])
+        :   string(key),
+            integer(0),
+            length(I - 1)
+    {}
+
+    bool matches(const uint8_t* pointer, const CborgHeader& head) const;
+
+    // same, for keys that are not in one piece of memory: string payloads
+    // are compared by equals(string, length)
+    template <typename Equals>
+    bool matches(const CborgHeader& head, const Equals& equals) const
+    {
+        if (string)
+        {
+            // definite length strings are compared byte-by-byte
+            return (head.getMajorType() == CborBase::TypeString)
+                && (head.getMinorType() != CborBase::TypeIndefinite)
+                && (head.getValue() == length)
+                && equals(string, length);
+        }
+        else if (head.getMajorType() == CborBase::TypeUnsigned)
+        {
+            return (integer >= 0) && (head.getValue() == (uint64_t) integer);
+        }
+        else if (head.getMajorType() == CborBase::TypeNegative)
+        {
+            return (integer < 0) && (head.getValue() == (uint64_t) (-1 - (int64_t) integer));
+        }
+
+        return false;
+    }
+
+private:
+    const char* string;
+    int32_t integer;
+    std::size_t length;
+};
+
 class Cborg
 {
 public:
     Cborg();
     Cborg(const uint8_t* cbor, std::size_t maxLength);
 
+    /*
+        Check that the item at cbor is well-formed and fits in maxLength.
+        Returns a handle whose lookups skip all bounds and consistency
+        checks, or a null object if the item is not well-formed.
+    */
+    static Cborg validate(const uint8_t* cbor, std::size_t maxLength);
+
+    bool isValidated() const;
+
     /* Decode methods */
-    bool getCBOR(const uint8_t** pointer, uint32_t* length);
-    uint32_t getCBORLength();
+    bool getCBOR(const uint8_t** pointer, uint32_t* length) const;
+    std::size_t getCBORLength() const;
 
     /* map functions */
     template <std::size_t I>
@@ -44,16 +111,70 @@ public:
     Cborg find(int32_t key) const;
     Cborg find(const char* key, std::size_t keyLength) const;
 
+    // find values for several keys in one pass over the map, values of
+    // missing keys are set to null, returns the number of keys found
+    template <std::size_t I>
+    std::size_t find(const CborgKey (&keys)[I], Cborg (&values)[I]) const
+    {
+        return find(keys, values, I);
+    }
+
+    std::size_t find(const CborgKey* keys, Cborg* values, std::size_t count) const;
+
+    // follow compiled path from this object
+    Cborg find(const CborgPath& path) const;
+
     Cborg at(std::size_t index) const;
 
+    /* iteration, e.g., for (Cborg item : array.elements()) */
+    CborgRange<CborgIterator> elements() const;
+    CborgRange<CborgPairIterator> pairs() const;
+
     uint32_t getSize() const;
 
-    /* non-container functions */
+    /*
+        Non-container functions. Each returns false if the item has a
+        different type or its value does not fit in the result.
+    */
     bool getUnsigned(uint32_t*) const;
+    bool getUnsigned(uint64_t*) const;
     bool getNegative(int32_t*) const;
+    bool getNegative(int64_t*) const;
+
+    // unsigned or negative integer
+    bool getInteger(int64_t*) const;
 
+    // half, single or double precision float
+    bool getFloat(float*) const;
+    bool getDouble(double*) const;
+
+    // elements of an array of floats, stops at the first element that is
+    // not a float or not exact in single precision, returns values read
+    std::size_t getFloats(float* values, std::size_t count) const;
+
+    /*
+        RFC 8746 typed array of T in either byte order. Read in place when
+        the byte order matches the host and the payload is aligned for T,
+        otherwise copied into buffer, swapping bytes as needed. The view is
+        null if the item is not such an array or the copy does not fit.
+    */
+    template <typename T>
+    CborgTypedArray<T> getTypedArray(T* buffer = NULL, std::size_t capacity = 0) const
+    {
+        std::size_t count = 0;
+        bool copied = false;
+
+        const void* values = typedArray(CborgTyped::tag<T>(), sizeof(T), buffer, capacity, &count, &copied);
+
+        return CborgTypedArray<T>((const T*) values, count, copied);
+    }
+
+    // definite length payloads that lie within maxLength, indefinite length
+    // bytes and strings are chunked and can not be returned in place
     bool getBytes(const uint8_t** pointer, uint32_t* length) const;
+    bool getBytes(const uint8_t** pointer, uint64_t* length) const;
     bool getString(const char** pointer, uint32_t* length) const;
+    bool getString(const char** pointer, uint64_t* length) const;
     bool getString(std::string& str) const;
 
     /* pass through to header */
@@ -65,8 +186,96 @@ public:
     void print() const;
 
 private:
+    friend class CborgIterator;
+    friend class CborgPairIterator;
+
+    Cborg(const uint8_t* cbor, std::size_t maxLength, bool validated);
+
+    template <typename Match>
+    void findPairs(Match& match) const;
+
+    const void* typedArray(uint32_t tag, std::size_t width, void* buffer, std::size_t capacity,
+                           std::size_t* count, bool* copied) const;
+
+    const uint8_t* cbor;
+    std::size_t maxLength;
+    bool validated;
+};
+
+/*
+    Forward iterator over the elements of an array. Each step skips exactly
+    one item, so walking the whole array is linear in its encoded size.
+*/
+class CborgIterator
+{
+public:
+    // end iterator
+    CborgIterator();
+
+    // first element of the array or map at cbor
+    CborgIterator(const uint8_t* cbor, std::size_t maxLength, bool pairs, bool validated = false);
+
+    Cborg operator*() const;
+    CborgIterator& operator++();
+
+    bool operator==(const CborgIterator& other) const;
+    bool operator!=(const CborgIterator& other) const;
+
+protected:
+    void settle();
+
     const uint8_t* cbor;
     std::size_t maxLength;
+    std::size_t progress;   // current element or key
+    std::size_t keyLength;  // encoded size of current key, maps only
+    std::size_t units;      // remaining elements or pairs
+    bool indefinite;
+    bool pairs;
+    bool validated;
+    bool done;
+};
+
+typedef struct {
+    Cborg key;
+    Cborg value;
+} CborgPair;
+
+/*
+    Forward iterator over the key-value pairs of a map.
+*/
+class CborgPairIterator : public CborgIterator
+{
+public:
+    CborgPairIterator();
+    CborgPairIterator(const uint8_t* cbor, std::size_t maxLength, bool validated = false);
+
+    CborgPair operator*() const;
+    CborgPairIterator& operator++();
+};
+
+/*
+    Range for use in range-based for loops.
+*/
+template <typename Iterator>
+class CborgRange
+{
+public:
+    CborgRange(const Iterator& _first)
+        :   first(_first)
+    {}
+
+    Iterator begin() const
+    {
+        return first;
+    }
+
+    Iterator end() const
+    {
+        return Iterator();
+    }
+
+private:
+    Iterator first;
 };
 
 #endif // __CBORG_H__
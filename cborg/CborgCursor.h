@@ -0,0 +1,106 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __CBORG_CURSOR_H__
+#define __CBORG_CURSOR_H__
+
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+
+#include "cborg/CborgHeader.h"
+#include "cborg/CborgStack.h"
+#include "cborg/CborgTraverse.h"
+#include "cborg/CborBase.h"
+#include "cborg/Cborg.h"
+
+/*
+    Pull parser for consuming a CBOR buffer strictly front to back.
+
+    The cursor is either on an item or at the end of the current container.
+    Items are read in document order with:
+
+        next()  step to the following item, containers are entered and
+                left automatically.
+        skip()  step over the current item, including everything inside it.
+        enter() step into the current container, onto its first item.
+        leave() skip the rest of the current container and step to the
+                item following it.
+
+    Bytes already passed are never decoded again. Indefinite length strings
+    are treated as containers holding their chunks. Once the buffer turns
+    out to be truncated or malformed every call fails and getStatus()
+    reports why.
+*/
+class CborgCursor
+{
+public:
+    CborgCursor(const uint8_t* cbor, std::size_t maxLength);
+
+    /* Movement, returns false at the end of the document or on error */
+    bool next();
+    bool skip();
+    bool enter();
+    bool leave();
+
+    /* Position */
+    bool isEnd() const;
+    std::size_t getDepth() const;
+    std::size_t getOffset() const;
+    CborgTraverse::Status_t getStatus() const;
+
+    /* Current item, header values */
+    uint32_t getTag() const;
+    uint8_t getType() const;
+    uint8_t getMinorType() const;
+    uint32_t getSize() const;
+
+    /* Current item, typed reads, false if the value does not fit */
+    bool getUnsigned(uint32_t* integer) const;
+    bool getUnsigned(uint64_t* integer) const;
+    bool getNegative(int32_t* integer) const;
+    bool getNegative(int64_t* integer) const;
+    bool getInteger(int64_t* integer) const;
+    bool getFloat(float* value) const;
+    bool getDouble(double* value) const;
+    bool getBytes(const uint8_t** pointer, uint32_t* length) const;
+    bool getBytes(const uint8_t** pointer, uint64_t* length) const;
+    bool getString(const char** pointer, uint32_t* length) const;
+    bool getString(const char** pointer, uint64_t* length) const;
+    bool getString(std::string& str) const;
+
+    /* Current item including its subtree */
+    Cborg getCborg() const;
+
+private:
+    bool isContainer() const;
+    bool push();
+    void settle();
+    bool fail(CborgTraverse::Status_t status);
+
+    const uint8_t* cbor;
+    std::size_t maxLength;
+    std::size_t progress;
+
+    CborgHeader head;
+    CborgTraverse::Status_t status;
+    bool end;
+
+    // remaining items on the document level and in each open container
+    CborgStack<std::size_t, CBORG_MAX_DEPTH + 1> frames;
+};
+
+#endif // __CBORG_CURSOR_H__
@@ -0,0 +1,70 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __CBORG_FLOAT_H__
+#define __CBORG_FLOAT_H__
+
+#include <stdint.h>
+#include <cstddef>
+
+/*
+    Conversion between half, single and double precision.
+
+    Conversions to half precision round to nearest even, overflow to
+    infinity and keep NaNs quiet with the top bits of their payload, like
+    the F16C instructions. Half precision NaNs are widened as quiet NaNs.
+
+    The bulk conversions use F16C, eight values at a time, when the CPU
+    supports it; the implementation is selected at runtime. Other targets
+    use the scalar versions.
+*/
+class CborgFloat
+{
+public:
+    typedef enum {
+        ConvertScalar   = 0x00,
+        ConvertF16C     = 0x01
+    } Convert_t;
+
+    static float halfToFloat(uint16_t half);
+    static double halfToDouble(uint16_t half);
+    static uint16_t floatToHalf(float value);
+
+    /* Bulk conversion of count values */
+    static void halfToFloat(const uint16_t* source, float* destination, std::size_t count);
+    static void floatToHalf(const float* source, uint16_t* destination, std::size_t count);
+
+    /*
+        Shortest encoding that keeps the value bit for bit: the initial
+        byte minor type (TypeHalfFloat, TypeSingleFloat or TypeDoubleFloat)
+        is returned and bits is set to the encoded argument.
+    */
+    static uint8_t shortest(double value, uint64_t* bits);
+    static uint8_t shortest(float value, uint64_t* bits);
+
+    /*
+        Value of a float item with the given minor type and argument.
+        narrow() also fails if the value is not exact in single precision.
+    */
+    static bool widen(uint8_t simpleType, uint64_t bits, double* value);
+    static bool narrow(uint8_t simpleType, uint64_t bits, float* value);
+
+    /* Implementation in use, can be lowered for testing and benchmarks */
+    static Convert_t getImplementation();
+    static Convert_t setImplementation(Convert_t implementation);
+};
+
+#endif // __CBORG_FLOAT_H__
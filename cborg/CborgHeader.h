@@ -20,12 +20,33 @@
 #include "cborg/CborBase.h"
 
 #include <stdint.h>
-
-
-
+#include <cstddef>
+#include <string.h>
+
+/*
+    Decoded item header, i.e., optional semantic tag, major type, minor type,
+    and argument value.
+
+    Every initial byte is looked up in a 256-entry table, computed at compile
+    time, that gives the major type, the width of the argument that follows,
+    and whether the item is a container, indefinite, followed by a payload,
+    or uses a reserved minor type. Reserved items decode as TypeUnassigned.
+    Arguments are read with single byte-swapping loads and kept at their
+    full 64-bit width; tags are kept as their low 32 bits.
+*/
 class CborgHeader
 {
 public:
+    typedef enum {
+        InfoWidth       = 0x000F,   // bytes following the initial byte: 0, 1, 2, 4, or 8
+        InfoContainer   = 0x0010,   // map or array
+        InfoIndefinite  = 0x0020,   // minor type 31
+        InfoPayload     = 0x0040,   // definite bytes or string, value is payload length
+        InfoReserved    = 0x0080,   // minor type not allowed for major type
+        InfoNested      = 0x0100,   // map, array, or indefinite bytes or string
+        InfoMajorShift  = 12        // major type in the top bits
+    } Info_t;
+
     CborgHeader() {}
 
     void decode(const uint8_t* head)
@@ -34,96 +55,71 @@ public:
         tag = 0xFF;
         majorType = CborBase::TypeSpecial;
         minorType = CborBase::TypeNull;
+        info = 0;
         length = 0;
         value = 0;
 
         // null pointer check
         if (head)
         {
-            // read types
-            majorType = head[0] >> 5;
-            minorType = head[0] & 31;
+            length = decodeItem(head);
 
-            // use types to read value with proper length
-            if (minorType < 24)
+            // the first type was a semantic tag, read the next header
+            if (majorType == CborBase::TypeTag)
             {
-                value = minorType;
+                // store previous value as the tag
+                tag = (uint32_t) value;
 
-                length = 1;
+                length += decodeItem(&head[length]);
             }
-            else if (minorType == 24)
-            {
-                value = head[1];
+        }
+    }
 
-                length = 2;
-            }
-            else if (minorType == 25) // 2 bytes
-            {
-                value = ((uint16_t) head[1] << 8) | head[2];
+    // tag and item header take at most 9 bytes each
+    static const std::size_t MaxLength = 18;
 
-                length = 3;
-            }
-            else if (minorType == 26) // 4 bytes
-            {
-                value = ((uint32_t) head[1] << 24)
-                      | ((uint32_t) head[2] << 16)
-                      | ((uint32_t) head[3] << 8)
-                      |             head[4];
+    /*
+        Decode only if the header, including a leading tag and the header
+        after it, lies within maxLength. Otherwise the header is reset as
+        for a null pointer and false is returned.
+    */
+    bool decode(const uint8_t* head, std::size_t maxLength)
+    {
+        std::size_t width = 0;
 
-                length = 5;
-            }
-            else if (minorType == CborBase::TypeIndefinite)
-            {
-                value = 31;
-                length = 1;
-            }
+        if (head && (maxLength > 0))
+        {
+            width = 1 + (table[head[0]] & InfoWidth);
 
-            // the first type was a semantic tag, read the next header
-            if (majorType == CborBase::TypeTag)
+            if ((head[0] >> 5) == CborBase::TypeTag)
             {
-                // store previous value as the tag
-                tag = value;
-
-                // read next type
-                majorType = head[length] >> 5;
-                minorType = head[length] & 31;
-
-                // read value based on length in type
-                if (minorType < 24)
-                {
-                    value = minorType;
-
-                    length += 1;
-                }
-                else if (minorType == 24)
-                {
-                    value = head[length + 1];
-
-                    length += 2;
-                }
-                else if (minorType == 25)
-                {
-                    value = ((uint16_t) head[length + 1] << 8) | head[length + 2];
-
-                    length += 3;
-                }
-                else if (minorType == 26)
-                {
-                    value = ((uint32_t) head[length + 1] << 24)
-                          | ((uint32_t) head[length + 2] << 16)
-                          | ((uint32_t) head[length + 3] << 8)
-                          |             head[length + 4];
-                    length += 5;
-                }
-                else if (minorType == CborBase::TypeIndefinite)
-                {
-                    value = 31;
-                    length += 1;
-                }
+                // the tagged item's header must start within bounds
+                width = (width < maxLength) ? width + 1 + (table[head[width]] & InfoWidth) : maxLength + 1;
             }
         }
+
+        if ((width == 0) || (width > maxLength))
+        {
+            decode(NULL);
+
+            return false;
+        }
+
+        decode(head);
+
+        return true;
+    }
+
+    /* table entry for initial byte */
+    static uint16_t getInfo(uint8_t initial)
+    {
+        return table[initial];
     }
 
+    uint16_t getInfo() const
+    {
+        return info;
+    }
 
     uint32_t getTag() const
     {
@@ -140,7 +136,7 @@ public:
         return minorType;
     }
 
-    uint32_t getValue() const
+    uint64_t getValue() const
     {
         return value;
     }
@@ -151,11 +147,106 @@ public:
     }
 
 private:
+    uint8_t decodeItem(const uint8_t* head)
+    {
+        info = table[head[0]];
+
+        majorType = head[0] >> 5;
+        minorType = head[0] & 31;
+
+        // the argument width is taken from the minor type rather than the
+        // table: the branches predict well and keep the table load off the
+        // critical path when skipping items
+        if (minorType < 24)
+        {
+            value = minorType;
+
+            return 1;
+        }
+        else if (minorType == 24)
+        {
+            value = head[1];
+
+            return 2;
+        }
+        else if (minorType == 25)
+        {
+            value = readUint16(&head[1]);
+
+            return 3;
+        }
+        else if (minorType == 26)
+        {
+            value = readUint32(&head[1]);
+
+            return 5;
+        }
+        else if (minorType == 27)
+        {
+            value = readUint64(&head[1]);
+
+            return 9;
+        }
+
+        // indefinite, or reserved minor type marked as unassigned
+        if (info & InfoReserved)
+        {
+            majorType = CborBase::TypeUnassigned;
+        }
+
+        value = minorType;
+
+        return 1;
+    }
+
+    static uint16_t readUint16(const uint8_t* head)
+    {
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+        uint16_t result;
+        memcpy(&result, head, sizeof(result));
+
+        return __builtin_bswap16(result);
+#else
+        return ((uint16_t) head[0] << 8) | head[1];
+#endif
+    }
+
+    static uint32_t readUint32(const uint8_t* head)
+    {
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+        uint32_t result;
+        memcpy(&result, head, sizeof(result));
+
+        return __builtin_bswap32(result);
+#else
+        return ((uint32_t) head[0] << 24)
+             | ((uint32_t) head[1] << 16)
+             | ((uint32_t) head[2] << 8)
+             |             head[3];
+#endif
+    }
+
+    static uint64_t readUint64(const uint8_t* head)
+    {
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+        uint64_t result;
+        memcpy(&result, head, sizeof(result));
+
+        return __builtin_bswap64(result);
+#else
+        return ((uint64_t) readUint32(head) << 32) | readUint32(&head[4]);
+#endif
+    }
+
+private:
+    static const uint16_t table[256];
+
     uint32_t tag;
+    uint16_t info;
     uint8_t majorType;
     uint8_t minorType;
     uint8_t length;
-    uint32_t value;
+    uint64_t value;
 };
 
 #endif // __CBOR_HEADER_H__
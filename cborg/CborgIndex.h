@@ -0,0 +1,126 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __CBORG_INDEX_H__
+#define __CBORG_INDEX_H__
+
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+
+#include "cborg/CborgHeader.h"
+#include "cborg/CborBase.h"
+#include "cborg/Cborg.h"
+
+class CborgIndexed;
+
+/*
+    Structural index ("tape") of a CBOR buffer.
+
+    build() walks the buffer once and records every item in document order:
+    the offset of its header, the end of its subtree and, for containers,
+    where its direct children are listed. Lookups through CborgIndexed are
+    then answered from the index without decoding the buffer again.
+
+    The buffer must outlive the index and must not change after build().
+*/
+class CborgIndex
+{
+public:
+    typedef struct {
+        uint32_t offset;    // header position in buffer
+        uint32_t end;       // one past the last byte of the subtree
+        uint32_t next;      // entry following the subtree, i.e., next sibling
+        uint32_t children;  // position of first child in child table
+        uint32_t size;      // number of direct children
+    } Entry_t;
+
+    CborgIndex();
+
+    /* Build index, returns false if the buffer is not well-formed or
+       larger than the 32-bit offsets can address */
+    bool build(const uint8_t* cbor, std::size_t maxLength);
+
+    /* Release index, keeps allocated storage for reuse */
+    void clear();
+
+    /* Root of the indexed document */
+    CborgIndexed root() const;
+
+    /* Number of items in index */
+    std::size_t getEntries() const;
+
+private:
+    friend class CborgIndexed;
+
+    const uint8_t* cbor;
+    std::size_t maxLength;
+
+    std::vector<Entry_t> entries;
+    std::vector<uint32_t> table;
+};
+
+/*
+    Cborg variant backed by a CborgIndex.
+
+    find() compares only the keys of the map, at() and getCBORLength() are
+    constant time. Use getCborg() to read values.
+*/
+class CborgIndexed
+{
+public:
+    CborgIndexed();
+    CborgIndexed(const CborgIndex* index, uint32_t entry);
+
+    /* Decode methods */
+    bool getCBOR(const uint8_t** pointer, uint32_t* length) const;
+    std::size_t getCBORLength() const;
+
+    /* map functions */
+    template <std::size_t I>
+    CborgIndexed find(const char (&key)[I]) const
+    {
+        return find(key, I - 1);
+    }
+
+    CborgIndexed find(int32_t key) const;
+    CborgIndexed find(const char* key, std::size_t keyLength) const;
+
+    CborgIndexed at(std::size_t index) const;
+
+    // number of elements, also for indefinite length containers
+    uint32_t getSize() const;
+
+    /* plain decoder for the indexed item */
+    Cborg getCborg() const;
+
+    /* pass through to header */
+    uint32_t getTag() const;
+    uint8_t getType() const;
+    uint8_t getMinorType() const;
+
+    /* debug */
+    void print() const;
+
+private:
+    // value of the first matching key
+    CborgIndexed find(const CborgKey& key) const;
+
+    const CborgIndex* index;
+    uint32_t entry;
+};
+
+#endif // __CBORG_INDEX_H__
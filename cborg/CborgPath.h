@@ -0,0 +1,91 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __CBORG_PATH_H__
+#define __CBORG_PATH_H__
+
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+
+#include "cborg/CborgStack.h"
+#include "cborg/Cborg.h"
+
+/*
+    Compiled path expression for nested lookups.
+
+    A path is a sequence of steps written as:
+
+        name        string key in a map, separated from earlier steps by '.'
+        [index]     element in an array
+        {integer}   integer key in a map
+
+    For example "body.intents[2].endpoint" or "{7}[0]". The path is parsed
+    once by compile() and can then be evaluated against any number of
+    buffers. An empty path selects the item itself.
+
+    Evaluation is a single forward scan that only descends into the
+    containers on the path and does not allocate memory. Keys are compared
+    with CborgKey and everything that does not match is skipped with the
+    traversal engine, without checks when the path is used through
+    Cborg::find() on a validated handle.
+*/
+class CborgPath
+{
+public:
+    CborgPath();
+    CborgPath(const char* path);
+
+    /* Parse path, returns false if the path is malformed or too deep */
+    bool compile(const char* path);
+    bool compile(const char* path, std::size_t length);
+
+    /* Path compiled successfully */
+    bool isValid() const;
+
+    /* Number of steps in path */
+    std::size_t getSteps() const;
+
+    /* Item at the end of the path, null object if not found */
+    Cborg evaluate(const uint8_t* cbor, std::size_t maxLength) const;
+
+private:
+    typedef enum {
+        StepString  = 0x00,
+        StepInteger = 0x01,
+        StepIndex   = 0x02
+    } Step_t;
+
+    typedef struct {
+        uint8_t type;
+        uint32_t offset;    // string keys: position in path
+        uint32_t length;    // string keys: length of key
+        int32_t value;      // integer key or array index
+    } Entry_t;
+
+    bool parseNumber(std::size_t* position, char end, bool sign, int32_t* value) const;
+
+    // offset of the item at the end of the path, used by Cborg::find()
+    bool locate(const uint8_t* cbor, std::size_t maxLength, bool validated, std::size_t* offset) const;
+
+    friend class Cborg;
+
+    std::string path;
+    CborgStack<Entry_t> steps;
+    bool valid;
+};
+
+#endif // __CBORG_PATH_H__
@@ -0,0 +1,317 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __CBORG_SAX_H__
+#define __CBORG_SAX_H__
+
+#include <stdint.h>
+#include <cstddef>
+#include <string.h>
+#include <limits>
+
+#include "cborg/CborgFloat.h"
+#include "cborg/CborgHeader.h"
+#include "cborg/CborgStack.h"
+#include "cborg/CborgTraverse.h"
+#include "cborg/CborBase.h"
+
+/*
+    Default event handler, every event is ignored.
+
+    Handlers for CborgSax::decode() derive from this class and hide the
+    events they are interested in. Calls are resolved at compile time so
+    nothing needs to be virtual. Returning false stops the decoder.
+
+    Container sizes are reported as UINT32_MAX for indefinite length
+    containers. Definite length strings are reported as a single chunk,
+    indefinite length strings as beginString(), one chunk per segment and
+    endString(). key() is called before each key in a map, the key itself
+    is reported like any other item.
+
+    Integers are reported with integer() when they fit in int64_t and with
+    largeInteger(), giving the sign and the encoded argument, otherwise.
+*/
+class CborgHandler
+{
+public:
+    bool beginMap(uint32_t) { return true; }
+    void endMap() {}
+
+    bool beginArray(uint32_t) { return true; }
+    void endArray() {}
+
+    bool key() { return true; }
+
+    bool integer(int64_t) { return true; }
+    bool largeInteger(bool, uint64_t) { return true; }
+
+    bool beginString() { return true; }
+    bool string(const char*, std::size_t) { return true; }
+    void endString() {}
+
+    bool beginBytes() { return true; }
+    bool bytes(const uint8_t*, std::size_t) { return true; }
+    void endBytes() {}
+
+    bool tag(uint32_t) { return true; }
+    bool simple(uint8_t) { return true; }
+    bool floating(double) { return true; }
+};
+
+/*
+    Event driven decoder.
+
+    decode() walks one item, including everything nested inside it, and
+    calls the handler for each event in document order. No Cborg objects
+    are created and nothing is allocated.
+*/
+class CborgSax
+{
+public:
+    template <typename Handler>
+    static CborgTraverse::Status_t decode(const uint8_t* cbor, std::size_t maxLength, Handler& handler, std::size_t* length = NULL)
+    {
+        Adapter<Handler> adapter(cbor, maxLength, handler);
+        std::size_t progress = 0;
+
+        CborgTraverse::Status_t status = CborgTraverse::visit(cbor, maxLength, adapter, &progress);
+
+        if (adapter.truncated)
+        {
+            return CborgTraverse::StatusTruncated;
+        }
+
+        if (length)
+        {
+            *length = progress;
+        }
+
+        return status;
+    }
+
+    /* Begin event for a container or indefinite string */
+    template <typename Handler>
+    static bool begin(const CborgHeader& head, Handler& handler)
+    {
+        uint8_t type = head.getMajorType();
+        uint32_t size = (uint32_t) head.getValue();
+
+        if (head.getMinorType() == CborBase::TypeIndefinite)
+        {
+            size = std::numeric_limits<uint32_t>::max();
+        }
+
+        if (type == CborBase::TypeMap)
+        {
+            return handler.beginMap(size);
+        }
+        else if (type == CborBase::TypeArray)
+        {
+            return handler.beginArray(size);
+        }
+        else if (type == CborBase::TypeString)
+        {
+            return handler.beginString();
+        }
+        else
+        {
+            return handler.beginBytes();
+        }
+    }
+
+    /* End event for a container or indefinite string of the given type */
+    template <typename Handler>
+    static void end(uint8_t type, Handler& handler)
+    {
+        if (type == CborBase::TypeMap)
+        {
+            handler.endMap();
+        }
+        else if (type == CborBase::TypeArray)
+        {
+            handler.endArray();
+        }
+        else if (type == CborBase::TypeString)
+        {
+            handler.endString();
+        }
+        else
+        {
+            handler.endBytes();
+        }
+    }
+
+    /*
+        Event for an integer, nested tag, simple value or float with the
+        decoded header head.
+    */
+    template <typename Handler>
+    static bool scalar(const CborgHeader& head, Handler& handler)
+    {
+        uint8_t type = head.getMajorType();
+        uint8_t simple = head.getMinorType();
+        uint64_t value = head.getValue();
+
+        if ((type == CborBase::TypeUnsigned) || (type == CborBase::TypeNegative))
+        {
+            bool negative = (type == CborBase::TypeNegative);
+
+            if (value > (uint64_t) std::numeric_limits<int64_t>::max())
+            {
+                return handler.largeInteger(negative, value);
+            }
+
+            return handler.integer(negative ? -1 - (int64_t) value : (int64_t) value);
+        }
+        else if (type == CborBase::TypeTag)
+        {
+            // second tag on the same item, the tagged item follows
+            return handler.tag((uint32_t) value);
+        }
+        else if (simple == CborBase::TypeHalfFloat)
+        {
+            return handler.floating(CborgFloat::halfToDouble((uint16_t) value));
+        }
+        else if (simple == CborBase::TypeSingleFloat)
+        {
+            uint32_t bits = (uint32_t) value;
+            float single;
+            memcpy(&single, &bits, sizeof(single));
+
+            return handler.floating(single);
+        }
+        else if (simple == CborBase::TypeDoubleFloat)
+        {
+            double number;
+            memcpy(&number, &value, sizeof(number));
+
+            return handler.floating(number);
+        }
+        else
+        {
+            return handler.simple(value);
+        }
+    }
+
+private:
+    /*
+        Translate traversal callbacks into handler events.
+    */
+    template <typename Handler>
+    class Adapter
+    {
+    public:
+        Adapter(const uint8_t* _cbor, std::size_t _maxLength, Handler& _handler)
+            :   truncated(false),
+                end(&_cbor[_maxLength]),
+                handler(_handler)
+        {}
+
+        bool item(const uint8_t* pointer, const CborgHeader& head, std::size_t)
+        {
+            // two tags on the same item, the tagged item follows
+            if (head.getMajorType() == CborBase::TypeTag)
+            {
+                return handler.tag(head.getTag()) && scalar(head, handler);
+            }
+
+            // keys are on even positions in maps
+            if (list.size() > 0)
+            {
+                Level_t& parent = list.back();
+
+                if ((parent.type == CborBase::TypeMap) && ((parent.count & 1) == 0)
+                    && !handler.key())
+                {
+                    return false;
+                }
+
+                parent.count++;
+            }
+
+            if ((head.getTag() != CborBase::TypeUnassigned) && !handler.tag(head.getTag()))
+            {
+                return false;
+            }
+
+            uint8_t type = head.getMajorType();
+            uint8_t simple = head.getMinorType();
+            uint64_t value = head.getValue();
+            const uint8_t* payload = &pointer[head.getLength()];
+
+            if ((type == CborBase::TypeMap) || (type == CborBase::TypeArray)
+                || (((type == CborBase::TypeBytes) || (type == CborBase::TypeString))
+                    && (simple == CborBase::TypeIndefinite)))
+            {
+                // containers and indefinite strings are completed in leave()
+                Level_t level = { type, 0 };
+
+                if (!list.push_back(level))
+                {
+                    return false;
+                }
+
+                return begin(head, handler);
+            }
+            else if ((type == CborBase::TypeBytes) || (type == CborBase::TypeString))
+            {
+                // the traversal only checks the length once the item is complete,
+                // and the header itself may already run past the end
+                if ((payload > end) || ((std::size_t) (end - payload) < value))
+                {
+                    truncated = true;
+
+                    return false;
+                }
+
+                if (type == CborBase::TypeString)
+                {
+                    return handler.string((const char*) payload, (std::size_t) value);
+                }
+                else
+                {
+                    return handler.bytes(payload, (std::size_t) value);
+                }
+            }
+
+            return scalar(head, handler);
+        }
+
+        void leave(const uint8_t*, std::size_t)
+        {
+            uint8_t type = list.back().type;
+            list.pop_back();
+
+            CborgSax::end(type, handler);
+        }
+
+        bool truncated;
+
+    private:
+        typedef struct {
+            uint8_t type;
+            uint32_t count;     // items seen so far
+        } Level_t;
+
+        const uint8_t* end;
+        Handler& handler;
+
+        // open containers, the traversal itself rejects deeper nesting
+        CborgStack<Level_t, CBORG_MAX_DEPTH + 1> list;
+    };
+};
+
+#endif // __CBORG_SAX_H__
@@ -0,0 +1,62 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __CBORG_SCAN_H__
+#define __CBORG_SCAN_H__
+
+#include <stdint.h>
+#include <cstddef>
+
+/*
+    Bulk scanning of byte ranges used by skipping and validation.
+
+    immediates() counts the leading run of one byte items, i.e., integers
+    0..23 and -1..-24 and simple values 0..23, so dense arrays of small
+    values are skipped many items at a time. utf8() validates text string
+    payloads.
+
+    On x86 the scanners use SSE2 and, when the CPU supports it, AVX2 to
+    classify 16 or 32 bytes at once; the implementation is selected at
+    runtime on first use. Other targets use the scalar versions.
+*/
+class CborgScan
+{
+public:
+    typedef enum {
+        ScanScalar  = 0x00,
+        ScanSSE2    = 0x01,
+        ScanAVX2    = 0x02
+    } Scan_t;
+
+    /* Number of leading one byte items in data, at most length */
+    static std::size_t immediates(const uint8_t* data, std::size_t length);
+
+    /* data is valid UTF-8 */
+    static bool utf8(const uint8_t* data, std::size_t length);
+
+    /* Implementation in use, can be lowered for testing and benchmarks */
+    static Scan_t getImplementation();
+    static Scan_t setImplementation(Scan_t implementation);
+
+    /* Initial byte encodes a complete one byte item */
+    static bool isImmediate(uint8_t initial)
+    {
+        // major types 0, 1, and 7 with the argument in the initial byte
+        return ((initial & 0x1F) < 24) && ((0x83 >> (initial >> 5)) & 1);
+    }
+};
+
+#endif // __CBORG_SCAN_H__
@@ -0,0 +1,113 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __CBORG_SCATTER_H__
+#define __CBORG_SCATTER_H__
+
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+
+#include "cborg/CborgHeader.h"
+#include "cborg/CborBase.h"
+#include "cborg/Cborg.h"
+
+/*
+    One piece of a non-contiguous buffer.
+*/
+typedef struct {
+    const uint8_t* data;
+    std::size_t length;
+} CborgSegment;
+
+/*
+    Cborg variant reading from a list of segments, e.g., a chain of
+    network buffers, without copying them into one contiguous buffer.
+
+    Headers and strings may straddle segment boundaries. getBytes() and
+    getString() return pointers into the segments when the payload lies
+    within a single segment and fail otherwise; getString(std::string&)
+    and copyBytes() always work.
+
+    The segment list and the data it points to must outlive the object.
+*/
+class CborgScatter
+{
+public:
+    CborgScatter();
+    CborgScatter(const CborgSegment* segments, std::size_t count);
+
+    /* Decode methods */
+    std::size_t getCBORLength() const;
+
+    /* map functions */
+    template <std::size_t I>
+    CborgScatter find(const char (&key)[I]) const
+    {
+        return find(key, I - 1);
+    }
+
+    CborgScatter find(int32_t key) const;
+    CborgScatter find(const char* key, std::size_t keyLength) const;
+
+    CborgScatter at(std::size_t index) const;
+
+    uint32_t getSize() const;
+
+    /* non-container functions, false if the value does not fit */
+    bool getUnsigned(uint32_t*) const;
+    bool getUnsigned(uint64_t*) const;
+    bool getNegative(int32_t*) const;
+    bool getNegative(int64_t*) const;
+    bool getInteger(int64_t*) const;
+
+    bool getBytes(const uint8_t** pointer, uint32_t* length) const;
+    bool getString(const char** pointer, uint32_t* length) const;
+    bool getString(std::string& str) const;
+
+    // copy payload of definite length bytes or string, returns bytes copied
+    uint32_t copyBytes(uint8_t* destination, uint32_t maxLength) const;
+
+    /* pass through to header */
+    uint32_t getTag() const;
+    uint8_t getType() const;
+    uint8_t getMinorType() const;
+
+    /* Cborg object for the item if it lies within one segment */
+    Cborg getCborg() const;
+
+private:
+    CborgScatter(const CborgSegment* segments, std::size_t count, std::size_t segment, std::size_t offset);
+
+    bool header(std::size_t segment, std::size_t offset, CborgHeader& head) const;
+    bool advance(std::size_t* segment, std::size_t* offset, std::size_t length) const;
+    bool skip(std::size_t* segment, std::size_t* offset) const;
+    std::size_t gather(std::size_t segment, std::size_t offset, uint8_t* destination, std::size_t length) const;
+    bool equals(std::size_t segment, std::size_t offset, const char* string, std::size_t length) const;
+
+    // value of the first matching key
+    CborgScatter find(const CborgKey& key) const;
+
+    // locate payload of definite length bytes or string
+    bool payload(uint8_t type, std::size_t* segment, std::size_t* offset, uint32_t* length) const;
+
+    const CborgSegment* segments;
+    std::size_t count;
+    std::size_t segment;
+    std::size_t offset;
+};
+
+#endif // __CBORG_SCATTER_H__
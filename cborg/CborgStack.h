@@ -0,0 +1,99 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __CBORG_STACK_H__
+#define __CBORG_STACK_H__
+
+#include <stdint.h>
+#include <cstddef>
+
+/*
+    Maximum container nesting the decoders will follow.
+    Deeper documents are rejected instead of allocating more memory.
+*/
+#ifndef CBORG_MAX_DEPTH
+#define CBORG_MAX_DEPTH 16
+#endif
+
+/*
+    Fixed size stack used for tracking container levels during traversal.
+    Storage is inline so a traversal never touches the heap. push_back()
+    returns false when the maximum depth has been reached.
+*/
+template <typename T, std::size_t N = CBORG_MAX_DEPTH>
+class CborgStack
+{
+public:
+    CborgStack()
+        :   count(0)
+    {}
+
+    bool push_back(const T& item)
+    {
+        if (count < N)
+        {
+            items[count++] = item;
+
+            return true;
+        }
+
+        return false;
+    }
+
+    void pop_back()
+    {
+        if (count > 0)
+        {
+            count--;
+        }
+    }
+
+    T& back()
+    {
+        return items[count - 1];
+    }
+
+    const T& back() const
+    {
+        return items[count - 1];
+    }
+
+    T& operator[](std::size_t index)
+    {
+        return items[index];
+    }
+
+    const T& operator[](std::size_t index) const
+    {
+        return items[index];
+    }
+
+    std::size_t size() const
+    {
+        return count;
+    }
+
+    static std::size_t capacity()
+    {
+        return N;
+    }
+
+private:
+    T items[N];
+    std::size_t count;
+};
+
+#endif // __CBORG_STACK_H__
@@ -0,0 +1,324 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __CBORG_STREAM_H__
+#define __CBORG_STREAM_H__
+
+#include <stdint.h>
+#include <cstddef>
+
+#include "cborg/CborgHeader.h"
+#include "cborg/CborgStack.h"
+#include "cborg/CborgTraverse.h"
+#include "cborg/CborgSax.h"
+#include "cborg/CborBase.h"
+
+/*
+    Incremental decoder for items arriving in fragments.
+
+    feed() accepts the next chunk of the encoding and returns:
+
+        StatusOk            item complete, consumed is the number of bytes
+                            used from this chunk; the rest belongs to the
+                            next item.
+        StatusTruncated     chunk used completely, more bytes are needed.
+        StatusStopped       the handler returned false.
+        StatusMalformed     the encoding is not well-formed.
+        StatusDepthExceeded the item is nested too deeply.
+
+    Everything except StatusTruncated is final until reset() is called.
+    Parse state (container levels, remaining units, partial headers and the
+    unread part of a string) is kept between calls, so chunks never need to
+    be copied into a reassembly buffer.
+
+    Events are the same as for CborgSax::decode(), except that definite
+    length strings are reported in one or more pieces as they arrive.
+*/
+class CborgStream
+{
+public:
+    CborgStream();
+
+    /* Prepare for a new item */
+    void reset();
+
+    /* Structure only */
+    CborgTraverse::Status_t feed(const uint8_t* chunk, std::size_t length, std::size_t* consumed);
+
+    /* With events */
+    template <typename Handler>
+    CborgTraverse::Status_t feed(const uint8_t* chunk, std::size_t length, Handler& handler, std::size_t* consumed)
+    {
+        std::size_t position = 0;
+
+        while ((status == CborgTraverse::StatusTruncated) && (position < length))
+        {
+            if (remaining > 0)
+            {
+                // string payload, pass on whatever is available
+                std::size_t part = length - position;
+
+                if (part > remaining)
+                {
+                    part = (std::size_t) remaining;
+                }
+
+                bool result = (stringType == CborBase::TypeString)
+                            ? handler.string((const char*) &chunk[position], part)
+                            : handler.bytes(&chunk[position], part);
+
+                position += part;
+                total += part;
+                remaining -= part;
+
+                if (!result)
+                {
+                    status = CborgTraverse::StatusStopped;
+                }
+                else if (remaining == 0)
+                {
+                    unwind(handler);
+                }
+            }
+            else
+            {
+                // collect header bytes until the header is complete
+                partial[fill++] = chunk[position++];
+                total++;
+
+                if (fill == needed())
+                {
+                    fill = 0;
+                    process(handler);
+                }
+            }
+        }
+
+        *consumed = position;
+
+        return status;
+    }
+
+    /* Bytes of the current item consumed so far */
+    std::size_t getLength() const;
+
+    /* Number of open containers */
+    std::size_t getDepth() const;
+
+private:
+    typedef struct {
+        uint64_t units;     // remaining units in the parent
+        uint32_t count;     // items seen in this container
+        uint8_t type;
+    } Level_t;
+
+    /*
+        Header length implied by the bytes collected so far. A tag is
+        followed by the header of the tagged item.
+    */
+    uint8_t needed() const
+    {
+        uint8_t first = 1 + (CborgHeader::getInfo(partial[0]) & CborgHeader::InfoWidth);
+
+        if (((partial[0] >> 5) == CborBase::TypeTag) && (fill >= first))
+        {
+            return first + 1 + (CborgHeader::getInfo(partial[first]) & CborgHeader::InfoWidth);
+        }
+
+        return first;
+    }
+
+    /*
+        Act on a complete header.
+    */
+    template <typename Handler>
+    void process(Handler& handler)
+    {
+        CborgHeader head;
+        head.decode(partial);
+
+        uint8_t type = head.getMajorType();
+        uint8_t simple = head.getMinorType();
+
+        if ((type == CborBase::TypeSpecial) && (simple == CborBase::TypeIndefinite))
+        {
+            // break is only valid as the end of an indefinite container
+            if ((list.size() == 0) || (units != indefinite))
+            {
+                status = CborgTraverse::StatusMalformed;
+                return;
+            }
+
+            pop(handler);
+            unwind(handler);
+
+            return;
+        }
+        else if (type == CborBase::TypeUnassigned)
+        {
+            // reserved minor type
+            status = CborgTraverse::StatusMalformed;
+            return;
+        }
+
+        // two tags on the same item, the tagged item follows
+        if (type == CborBase::TypeTag)
+        {
+            if (!handler.tag(head.getTag()) || !CborgSax::scalar(head, handler))
+            {
+                status = CborgTraverse::StatusStopped;
+            }
+
+            return;
+        }
+
+        // decrement unit count unless set to indefinite
+        if (units != indefinite)
+        {
+            units--;
+        }
+
+        // keys are on even positions in maps
+        if (list.size() > 0)
+        {
+            Level_t& parent = list.back();
+
+            if ((parent.type == CborBase::TypeMap) && ((parent.count & 1) == 0)
+                && !handler.key())
+            {
+                status = CborgTraverse::StatusStopped;
+                return;
+            }
+
+            parent.count++;
+        }
+
+        if ((head.getTag() != CborBase::TypeUnassigned) && !handler.tag(head.getTag()))
+        {
+            status = CborgTraverse::StatusStopped;
+            return;
+        }
+
+        bool result = true;
+
+        if ((type == CborBase::TypeMap) || (type == CborBase::TypeArray)
+            || (((type == CborBase::TypeBytes) || (type == CborBase::TypeString))
+                && (simple == CborBase::TypeIndefinite)))
+        {
+            Level_t level = { units, 0, type };
+
+            if (!list.push_back(level))
+            {
+                status = CborgTraverse::StatusDepthExceeded;
+                return;
+            }
+
+            if (simple == CborBase::TypeIndefinite)
+            {
+                units = indefinite;
+            }
+            else if (type == CborBase::TypeMap)
+            {
+                units = 2 * head.getValue();
+            }
+            else
+            {
+                units = head.getValue();
+            }
+
+            result = CborgSax::begin(head, handler);
+        }
+        else if ((type == CborBase::TypeBytes) || (type == CborBase::TypeString))
+        {
+            // payload follows in this or later chunks
+            remaining = head.getValue();
+            stringType = type;
+
+            if (remaining == 0)
+            {
+                result = (type == CborBase::TypeString)
+                       ? handler.string((const char*) &partial[head.getLength()], 0)
+                       : handler.bytes(&partial[head.getLength()], 0);
+            }
+        }
+        else
+        {
+            result = CborgSax::scalar(head, handler);
+        }
+
+        if (!result)
+        {
+            status = CborgTraverse::StatusStopped;
+        }
+        else if (remaining == 0)
+        {
+            unwind(handler);
+        }
+    }
+
+    /*
+        Close the innermost container.
+    */
+    template <typename Handler>
+    void pop(Handler& handler)
+    {
+        uint8_t type = list.back().type;
+
+        units = list.back().units;
+        list.pop_back();
+
+        CborgSax::end(type, handler);
+    }
+
+    /*
+        Step back up one level for each container that is complete.
+    */
+    template <typename Handler>
+    void unwind(Handler& handler)
+    {
+        while (units == 0)
+        {
+            if (list.size() > 0)
+            {
+                pop(handler);
+            }
+            else
+            {
+                status = CborgTraverse::StatusOk;
+                return;
+            }
+        }
+    }
+
+    // the stream has no total length, so counts keep all 64 bits
+    static const uint64_t indefinite = 0xFFFFFFFFFFFFFFFFULL;
+
+    CborgTraverse::Status_t status;
+    uint64_t units;
+    std::size_t total;
+
+    // unread payload of the current definite length string
+    uint64_t remaining;
+    uint8_t stringType;
+
+    // header split across chunks, tag and item header
+    uint8_t partial[18];
+    uint8_t fill;
+
+    CborgStack<Level_t> list;
+};
+
+#endif // __CBORG_STREAM_H__
@@ -0,0 +1,267 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __CBORG_TRAVERSE_H__
+#define __CBORG_TRAVERSE_H__
+
+#include <stdint.h>
+#include <cstddef>
+
+#include "cborg/CborgHeader.h"
+#include "cborg/CborgStack.h"
+#include "cborg/CborgScan.h"
+#include "cborg/CborBase.h"
+
+/*
+    Traversal engine shared by all decoders.
+
+    visit() walks exactly one item, including everything nested inside it,
+    and reports each item to the visitor in document order:
+
+        bool item(const uint8_t* pointer, const CborgHeader& head, std::size_t depth)
+            called for every item, return false to stop the traversal.
+
+        void leave(const uint8_t* end, std::size_t depth)
+            called when a container or indefinite string at depth is complete,
+            end points to the first byte after it.
+
+    skip() is visit() without a visitor and only computes the length. Runs
+    of one byte items are skipped in bulk with CborgScan.
+
+    validate() checks that one item is well-formed and fits in maxLength:
+    every header lies within the buffer, minor types 28-30 are not used,
+    break only ends indefinite containers, chunks of indefinite strings are
+    definite strings of the same type and nesting stays within
+    CBORG_MAX_DEPTH. Text strings must also be valid UTF-8. Items that pass
+    can be skipped with skipUnchecked(), which does no bounds or
+    consistency checks at all.
+*/
+class CborgTraverse
+{
+public:
+    typedef enum {
+        StatusOk            = 0x00,
+        StatusStopped       = 0x01,
+        StatusTruncated     = 0x02,
+        StatusDepthExceeded = 0x03,
+        StatusMalformed     = 0x04,
+        StatusInvalidUtf8   = 0x05
+    } Status_t;
+
+    // skip one item, length is set to the encoded size of the item
+    static Status_t skip(const uint8_t* cbor, std::size_t maxLength, std::size_t* length);
+
+    // check one item, length is set to the encoded size of the item
+    static Status_t validate(const uint8_t* cbor, std::size_t maxLength, std::size_t* length);
+
+    // skip one item that has passed validate(), returns the encoded size
+    static std::size_t skipUnchecked(const uint8_t* cbor);
+
+    template <typename Visitor>
+    static Status_t visit(const uint8_t* cbor, std::size_t maxLength, Visitor& visitor, std::size_t* length)
+    {
+        return walk<Visitor, false>(cbor, maxLength, visitor, length);
+    }
+
+private:
+    /*
+        With runs set, consecutive one byte items are passed over without
+        calling the visitor; only useful when the visitor ignores them.
+    */
+    template <typename Visitor, bool runs>
+    static Status_t walk(const uint8_t* cbor, std::size_t maxLength, Visitor& visitor, std::size_t* length)
+    {
+        static const std::size_t indefinite = (std::size_t) -1;
+
+        if (cbor == NULL)
+        {
+            return StatusTruncated;
+        }
+
+        // remaining units in each open container
+        CborgStack<std::size_t> list;
+        CborgHeader head;
+
+        std::size_t progress = 0;
+        std::size_t units = 1;
+
+        while (progress < maxLength)
+        {
+            // run of at least two one byte items inside a container
+            if (runs && (list.size() > 0) && (progress + 1 < maxLength)
+                && CborgScan::isImmediate(cbor[progress]) && CborgScan::isImmediate(cbor[progress + 1]))
+            {
+                std::size_t limit = maxLength - progress;
+
+                if ((units != indefinite) && (units < limit))
+                {
+                    limit = units;
+                }
+
+                std::size_t run = CborgScan::immediates(&cbor[progress], limit);
+
+                progress += run;
+
+                if (units != indefinite)
+                {
+                    units -= run;
+                }
+            }
+            else
+            {
+                // the complete header, including a tag, must be within bounds,
+                // which only needs checking near the end of the buffer; the
+                // decode itself stays on the straight path
+                if ((maxLength - progress < CborgHeader::MaxLength)
+                    && !head.decode(&cbor[progress], maxLength - progress))
+                {
+                    return StatusTruncated;
+                }
+
+                head.decode(&cbor[progress]);
+
+                uint8_t type = head.getMajorType();
+                uint8_t simple = head.getMinorType();
+
+                if ((type == CborBase::TypeSpecial) && (simple == CborBase::TypeIndefinite))
+                {
+                    // break is only valid as the end of an indefinite container
+                    if ((list.size() == 0) || (units != indefinite))
+                    {
+                        return StatusMalformed;
+                    }
+
+                    progress += head.getLength();
+
+                    units = list.back();
+                    list.pop_back();
+
+                    visitor.leave(&cbor[progress], list.size());
+                }
+                else if (type == CborBase::TypeUnassigned)
+                {
+                    // reserved minor type
+                    return StatusMalformed;
+                }
+                else if (type == CborBase::TypeTag)
+                {
+                    // second tag on the same item, the tagged item follows
+                    if (!visitor.item(&cbor[progress], head, list.size()))
+                    {
+                        *length = progress;
+
+                        return StatusStopped;
+                    }
+
+                    progress += head.getLength();
+                }
+                else
+                {
+                    // decrement unit count unless set to indefinite
+                    if (units != indefinite)
+                    {
+                        units--;
+                    }
+
+                    if (!visitor.item(&cbor[progress], head, list.size()))
+                    {
+                        *length = progress;
+
+                        return StatusStopped;
+                    }
+
+                    progress += head.getLength();
+
+                    // containers push remaining units onto the stack and
+                    // continue with the elements of the new container
+                    if ((type == CborBase::TypeMap) || (type == CborBase::TypeArray)
+                        || (((type == CborBase::TypeBytes) || (type == CborBase::TypeString))
+                            && (simple == CborBase::TypeIndefinite)))
+                    {
+                        if ((simple == CborBase::TypeIndefinite) || (head.getValue() > 0))
+                        {
+                            // every element takes at least one byte, so larger
+                            // counts can neither fit in the buffer nor in size_t
+                            if ((simple != CborBase::TypeIndefinite)
+                                && (head.getValue() > maxLength / ((type == CborBase::TypeMap) ? 2 : 1)))
+                            {
+                                return StatusTruncated;
+                            }
+
+                            if (!list.push_back(units))
+                            {
+                                return StatusDepthExceeded;
+                            }
+
+                            if (simple == CborBase::TypeIndefinite)
+                            {
+                                units = indefinite;
+                            }
+                            else if (type == CborBase::TypeMap)
+                            {
+                                units = 2 * (std::size_t) head.getValue();
+                            }
+                            else
+                            {
+                                units = (std::size_t) head.getValue();
+                            }
+                        }
+                        else
+                        {
+                            visitor.leave(&cbor[progress], list.size());
+                        }
+                    }
+                    else if ((type == CborBase::TypeBytes) || (type == CborBase::TypeString))
+                    {
+                        // compare before adding so 64-bit lengths can not wrap
+                        if ((progress > maxLength) || (head.getValue() > maxLength - progress))
+                        {
+                            return StatusTruncated;
+                        }
+
+                        progress += (std::size_t) head.getValue();
+                    }
+                }
+            }
+
+            // step back up one level for each container that is complete
+            while (units == 0)
+            {
+                if (list.size() > 0)
+                {
+                    units = list.back();
+                    list.pop_back();
+
+                    visitor.leave(&cbor[progress], list.size());
+                }
+                else if (progress <= maxLength)
+                {
+                    *length = progress;
+
+                    return StatusOk;
+                }
+                else
+                {
+                    return StatusTruncated;
+                }
+            }
+        }
+
+        return StatusTruncated;
+    }
+};
+
+#endif // __CBORG_TRAVERSE_H__
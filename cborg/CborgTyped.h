@@ -0,0 +1,150 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __CBORG_TYPED_H__
+#define __CBORG_TYPED_H__
+
+#include <stdint.h>
+#include <cstddef>
+
+/*
+    RFC 8746 typed arrays: a tag from 64 to 87 on a byte string whose
+    payload is the packed array. The tag gives the element type, its width
+    and its byte order.
+
+    CborgTypedTraits<T> gives the type bits for the element types that
+    have a tag: 8 to 64-bit integers, float and double.
+*/
+template <typename T>
+struct CborgTypedTraits;
+
+#define CBORG_TYPED_TRAITS(T, bits) \
+    template <> struct CborgTypedTraits<T> { static const uint8_t type = (bits); };
+
+// tag bits 0b010fsell without the endianness bit e
+CBORG_TYPED_TRAITS(uint8_t,  0x00)
+CBORG_TYPED_TRAITS(uint16_t, 0x01)
+CBORG_TYPED_TRAITS(uint32_t, 0x02)
+CBORG_TYPED_TRAITS(uint64_t, 0x03)
+CBORG_TYPED_TRAITS(int8_t,   0x08)
+CBORG_TYPED_TRAITS(int16_t,  0x09)
+CBORG_TYPED_TRAITS(int32_t,  0x0A)
+CBORG_TYPED_TRAITS(int64_t,  0x0B)
+CBORG_TYPED_TRAITS(float,    0x11)
+CBORG_TYPED_TRAITS(double,   0x12)
+
+#undef CBORG_TYPED_TRAITS
+
+class CborgTyped
+{
+public:
+    typedef enum {
+        TagFirst        = 64,
+        TagLast         = 87,
+        TagLittleEndian = 0x04      // set for little endian, or clamped for uint8_t
+    } Tag_t;
+
+    /* Tag for arrays of T in host byte order */
+    template <typename T>
+    static uint32_t tag()
+    {
+        // single byte elements have no byte order
+        return TagFirst | CborgTypedTraits<T>::type
+             | (((sizeof(T) > 1) && isLittleEndianHost()) ? TagLittleEndian : 0);
+    }
+
+    static bool isLittleEndianHost()
+    {
+#if defined(__BYTE_ORDER__)
+        return (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__);
+#else
+        const uint16_t probe = 1;
+        return *(const uint8_t*) &probe == 1;
+#endif
+    }
+
+    /*
+        Copy count elements of width bytes, reversing the byte order of
+        each. Uses SSE2 or AVX2 following CborgScan::getImplementation().
+    */
+    static void swap(const uint8_t* source, uint8_t* destination, std::size_t count, std::size_t width);
+};
+
+/*
+    View of the elements of a typed array. Points into the CBOR buffer when
+    the byte order and alignment allow it, otherwise into the buffer the
+    elements were copied to. Null view if the item is not a typed array of
+    T or a needed copy does not fit.
+*/
+template <typename T>
+class CborgTypedArray
+{
+public:
+    CborgTypedArray()
+        :   values(NULL),
+            count(0),
+            copied(false)
+    {}
+
+    CborgTypedArray(const T* _values, std::size_t _count, bool _copied)
+        :   values(_values),
+            count(_count),
+            copied(_copied)
+    {}
+
+    bool isValid() const
+    {
+        return (values != NULL);
+    }
+
+    // elements were copied instead of read in place
+    bool isCopy() const
+    {
+        return copied;
+    }
+
+    const T* data() const
+    {
+        return values;
+    }
+
+    std::size_t size() const
+    {
+        return count;
+    }
+
+    const T& operator[](std::size_t index) const
+    {
+        return values[index];
+    }
+
+    const T* begin() const
+    {
+        return values;
+    }
+
+    const T* end() const
+    {
+        return values + count;
+    }
+
+private:
+    const T* values;
+    std::size_t count;
+    bool copied;
+};
+
+#endif // __CBORG_TYPED_H__
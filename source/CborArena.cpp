@@ -0,0 +1,625 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "cborg/CborArena.h"
+#include "cborg/Cbore.h"
+#include "cborg/CborgStack.h"
+
+#include <new>
+#include <list>
+#include <string.h>
+#include <stdio.h>
+#include <cinttypes>
+
+/*****************************************************************************/
+/* Node                                                                      */
+/*****************************************************************************/
+
+CborNode::CborNode(MajorType_t _majorType, SimpleType_t _minorType)
+    :   CborBase(_majorType, _minorType)
+{
+    content.argument = 0;
+}
+
+uint32_t CborNode::getSize() const
+{
+    if ((majorType == TypeArray) || (majorType == TypeMap))
+    {
+        return content.container.count;
+    }
+
+    return 0;
+}
+
+CborBase* CborNode::at(std::size_t index)
+{
+    if ((majorType == TypeArray) && (index < content.container.count))
+    {
+        return content.container.items[index];
+    }
+
+    return &CborNull;
+}
+
+CborBase* CborNode::key(std::size_t index)
+{
+    if ((majorType == TypeMap) && (index < content.container.count))
+    {
+        return content.container.items[2 * index];
+    }
+
+    return &CborNull;
+}
+
+CborBase* CborNode::value(std::size_t index)
+{
+    if ((majorType == TypeMap) && (index < content.container.count))
+    {
+        return content.container.items[2 * index + 1];
+    }
+
+    return &CborNull;
+}
+
+CborNode* CborNode::find(const char* key, std::size_t length)
+{
+    if ((majorType != TypeMap) || (key == NULL))
+    {
+        return NULL;
+    }
+
+    for (std::size_t idx = 0; idx < content.container.count; idx++)
+    {
+        const CborNode* candidate = content.container.items[2 * idx];
+
+        if ((candidate->majorType == TypeString)
+            && (candidate->content.string.length == length)
+            && (memcmp(candidate->content.string.data, key, length) == 0))
+        {
+            return content.container.items[2 * idx + 1];
+        }
+    }
+
+    return NULL;
+}
+
+bool CborNode::getUnsigned(uint64_t* result) const
+{
+    if (majorType == TypeUnsigned)
+    {
+        *result = content.argument;
+
+        return true;
+    }
+
+    return false;
+}
+
+bool CborNode::getInteger(int64_t* result) const
+{
+    // arguments beyond INT64_MAX do not fit either way
+    if (((majorType == TypeUnsigned) || (majorType == TypeNegative)) && (content.argument <= INT64_MAX))
+    {
+        *result = (majorType == TypeUnsigned) ? (int64_t) content.argument : -1 - (int64_t) content.argument;
+
+        return true;
+    }
+
+    return false;
+}
+
+bool CborNode::getDouble(double* result) const
+{
+    if ((majorType == TypeSpecial) && (minorType == TypeSingleFloat))
+    {
+        float single;
+        uint32_t bits = content.argument;
+        memcpy(&single, &bits, sizeof(single));
+
+        *result = single;
+
+        return true;
+    }
+    else if ((majorType == TypeSpecial) && (minorType == TypeDoubleFloat))
+    {
+        memcpy(result, &content.argument, sizeof(double));
+
+        return true;
+    }
+
+    return false;
+}
+
+bool CborNode::getBytes(const uint8_t** pointer, uint32_t* length) const
+{
+    if (majorType == TypeBytes)
+    {
+        *pointer = content.string.data;
+        *length = content.string.length;
+
+        return true;
+    }
+
+    return false;
+}
+
+bool CborNode::getString(const char** pointer, uint32_t* length) const
+{
+    if (majorType == TypeString)
+    {
+        *pointer = (const char*) content.string.data;
+        *length = content.string.length;
+
+        return true;
+    }
+
+    return false;
+}
+
+bool CborNode::encode(Cbore& encoder) const
+{
+    typedef struct {
+        const CborNode* node;
+        std::size_t next;
+    } Frame_t;
+
+    // open containers and the next unit to write in each
+    CborgStack<Frame_t> list;
+
+    encodeHead(encoder);
+
+    if (((majorType == TypeArray) || (majorType == TypeMap)) && (content.container.count > 0))
+    {
+        Frame_t frame = { this, 0 };
+        list.push_back(frame);
+    }
+
+    while (list.size() > 0)
+    {
+        Frame_t& frame = list.back();
+        const CborNode* parent = frame.node;
+        std::size_t units = (parent->majorType == TypeMap) ? 2 * parent->content.container.count
+                                                           : parent->content.container.count;
+
+        if (frame.next == units)
+        {
+            list.pop_back();
+
+            continue;
+        }
+
+        const CborNode* child = parent->content.container.items[frame.next++];
+        child->encodeHead(encoder);
+
+        if (((child->majorType == TypeArray) || (child->majorType == TypeMap)) && (child->content.container.count > 0))
+        {
+            Frame_t next = { child, 0 };
+
+            if (!list.push_back(next))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void CborNode::encodeHead(Cbore& encoder) const
+{
+    if (tag != TypeUnassigned)
+    {
+        encoder.tag(tag);
+    }
+
+    switch (majorType)
+    {
+        case TypeUnsigned:
+            encoder.item(content.argument);
+            break;
+        case TypeNegative:
+            // created from int64_t, so the argument fits
+            encoder.item(-1 - (int64_t) content.argument);
+            break;
+        case TypeBytes:
+            encoder.item(content.string.data, content.string.length);
+            break;
+        case TypeString:
+            encoder.item((const char*) content.string.data, content.string.length);
+            break;
+        case TypeArray:
+            encoder.array(content.container.count);
+            break;
+        case TypeMap:
+            encoder.map(content.container.count);
+            break;
+        default:
+            if (minorType == TypeSingleFloat)
+            {
+                float single;
+                uint32_t bits = content.argument;
+                memcpy(&single, &bits, sizeof(single));
+
+                encoder.item(single);
+            }
+            else if (minorType == TypeDoubleFloat)
+            {
+                double value;
+                memcpy(&value, &content.argument, sizeof(value));
+
+                encoder.item(value);
+            }
+            else
+            {
+                encoder.item((SimpleType_t) minorType);
+            }
+            break;
+    }
+}
+
+uint32_t CborNode::writeCBOR(uint8_t* destination, uint32_t maxLength)
+{
+    if (destination == NULL)
+    {
+        return 0;
+    }
+
+    Cbore encoder(destination, maxLength);
+    encode(encoder);
+
+    return encoder.getLength();
+}
+
+void CborNode::print()
+{
+    if ((majorType == TypeArray) || (majorType == TypeMap))
+    {
+        std::list<CborBase*> queue;
+        queue.push_back(this);
+
+        printQueue(queue);
+
+        return;
+    }
+
+    // print tag if set
+    if (tag != TypeUnassigned)
+    {
+        printf("[%" PRIu32 "] ", tag);
+    }
+
+    int64_t integer;
+    double real;
+
+    if (getInteger(&integer))
+    {
+        printf("%" PRId64 "\r\n", integer);
+    }
+    else if (majorType == TypeUnsigned)
+    {
+        printf("%" PRIu64 "\r\n", content.argument);
+    }
+    else if (majorType == TypeString)
+    {
+        printf("%.*s\r\n", (int) content.string.length, (const char*) content.string.data);
+    }
+    else if (majorType == TypeBytes)
+    {
+        for (std::size_t idx = 0; idx < content.string.length; idx++)
+        {
+            printf("%02X", content.string.data[idx]);
+        }
+
+        printf("\r\n");
+    }
+    else if (getDouble(&real))
+    {
+        printf("%f\r\n", real);
+    }
+    else
+    {
+        const char* names[] = { "false", "true", "null", "undefined" };
+
+        printf("%s\r\n", ((minorType >= TypeFalse) && (minorType <= TypeUndefined)) ? names[minorType - TypeFalse] : "simple");
+    }
+}
+
+/*****************************************************************************/
+/* Arena                                                                     */
+/*****************************************************************************/
+
+CborArena::CborArena(uint8_t* _buffer, std::size_t _size)
+    :   buffer(_buffer),
+        size((_buffer) ? _size : 0),
+        used(0)
+{}
+
+void CborArena::reset()
+{
+    used = 0;
+}
+
+std::size_t CborArena::getUsed() const
+{
+    return used;
+}
+
+std::size_t CborArena::getCapacity() const
+{
+    return size;
+}
+
+CborNode* CborArena::array(std::size_t items)
+{
+    return createContainer(CborBase::TypeArray, items);
+}
+
+CborNode* CborArena::map(std::size_t pairs)
+{
+    return createContainer(CborBase::TypeMap, 2 * pairs);
+}
+
+CborNode* CborArena::simple(CborBase::SimpleType_t value)
+{
+    // floats, break and the two byte form are not simple values on their own
+    if (value > CborBase::TypeUndefined)
+    {
+        return NULL;
+    }
+
+    return create(CborBase::TypeSpecial, value);
+}
+
+CborNode* CborArena::floating(float value)
+{
+    CborNode* node = create(CborBase::TypeSpecial, CborBase::TypeSingleFloat);
+
+    if (node)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+
+        node->content.argument = bits;
+    }
+
+    return node;
+}
+
+CborNode* CborArena::floating(double value)
+{
+    CborNode* node = create(CborBase::TypeSpecial, CborBase::TypeDoubleFloat);
+
+    if (node)
+    {
+        memcpy(&node->content.argument, &value, sizeof(value));
+    }
+
+    return node;
+}
+
+CborNode* CborArena::string(const char* text, std::size_t length)
+{
+    CborNode* node = bytes((const uint8_t*) text, length);
+
+    if (node)
+    {
+        node->majorType = CborBase::TypeString;
+    }
+
+    return node;
+}
+
+CborNode* CborArena::bytes(const uint8_t* data, std::size_t length)
+{
+    if (((data == NULL) && (length > 0)) || (length > UINT32_MAX))
+    {
+        return NULL;
+    }
+
+    // undo the node if the copy does not fit
+    std::size_t mark = used;
+
+    CborNode* node = create(CborBase::TypeBytes, CborBase::TypeNull);
+    uint8_t* copy = (uint8_t*) allocate(length, 1);
+
+    if ((node == NULL) || (copy == NULL))
+    {
+        used = mark;
+
+        return NULL;
+    }
+
+    if (length > 0)
+    {
+        memcpy(copy, data, length);
+    }
+
+    node->content.string.data = copy;
+    node->content.string.length = length;
+
+    return node;
+}
+
+bool CborArena::append(CborNode* array, CborNode* item)
+{
+    if ((array == NULL) || (item == NULL) || (array->majorType != CborBase::TypeArray)
+        || !grow(array, array->content.container.count + 1))
+    {
+        return false;
+    }
+
+    array->content.container.items[array->content.container.count++] = item;
+
+    return true;
+}
+
+bool CborArena::insert(CborNode* map, CborNode* key, CborNode* value)
+{
+    if ((map == NULL) || (key == NULL) || (value == NULL) || (map->majorType != CborBase::TypeMap)
+        || !grow(map, 2 * map->content.container.count + 2))
+    {
+        return false;
+    }
+
+    CborNode** pair = &map->content.container.items[2 * map->content.container.count++];
+    pair[0] = key;
+    pair[1] = value;
+
+    return true;
+}
+
+bool CborArena::replace(CborNode* container, std::size_t index, CborNode* item)
+{
+    if ((container == NULL) || (item == NULL) || (index >= container->getSize()))
+    {
+        return false;
+    }
+
+    if (container->majorType == CborBase::TypeArray)
+    {
+        container->content.container.items[index] = item;
+    }
+    else
+    {
+        container->content.container.items[2 * index + 1] = item;
+    }
+
+    return true;
+}
+
+void* CborArena::allocate(std::size_t length, std::size_t alignment)
+{
+    // align the address, the buffer itself may have any alignment
+    std::size_t padding = (std::size_t) (-(uintptr_t) &buffer[used]) & (alignment - 1);
+    std::size_t start = used + padding;
+
+    if ((padding > size - used) || (length > size - start))
+    {
+        return NULL;
+    }
+
+    used = start + length;
+
+    return &buffer[start];
+}
+
+CborNode* CborArena::create(CborBase::MajorType_t majorType, CborBase::SimpleType_t minorType)
+{
+    void* memory = allocate(sizeof(CborNode), alignof(CborNode));
+
+    if (memory == NULL)
+    {
+        return NULL;
+    }
+
+    return new (memory) CborNode(majorType, minorType);
+}
+
+CborNode* CborArena::createInteger(bool negative, uint64_t argument)
+{
+    CborNode* node = create((negative) ? CborBase::TypeNegative : CborBase::TypeUnsigned, CborBase::TypeNull);
+
+    if (node)
+    {
+        node->content.argument = argument;
+    }
+
+    return node;
+}
+
+CborNode* CborArena::createContainer(CborBase::MajorType_t majorType, std::size_t units)
+{
+    std::size_t mark = used;
+
+    CborNode* node = create(majorType, CborBase::TypeNull);
+
+    if (node == NULL)
+    {
+        return NULL;
+    }
+
+    node->content.container.items = NULL;
+    node->content.container.count = 0;
+    node->content.container.capacity = 0;
+
+    if ((units > 0) && !grow(node, units))
+    {
+        used = mark;
+
+        return NULL;
+    }
+
+    return node;
+}
+
+// room for units child pointers, the capacity at least doubles
+bool CborArena::grow(CborNode* container, std::size_t units)
+{
+    static const std::size_t minimum = 4;
+
+    std::size_t capacity = container->content.container.capacity;
+
+    if (units <= capacity)
+    {
+        return true;
+    }
+
+    std::size_t larger = (2 * capacity > units) ? 2 * capacity : units;
+
+    if (larger < minimum)
+    {
+        larger = minimum;
+    }
+
+    if (larger > UINT32_MAX)
+    {
+        return false;
+    }
+
+    CborNode** items = container->content.container.items;
+
+    // last allocation in the arena, extend it in place
+    if ((items != NULL) && ((uint8_t*) &items[capacity] == &buffer[used])
+        && ((larger - capacity) * sizeof(CborNode*) <= size - used))
+    {
+        used += (larger - capacity) * sizeof(CborNode*);
+    }
+    else
+    {
+        CborNode** moved = (CborNode**) allocate(larger * sizeof(CborNode*), alignof(CborNode*));
+
+        if (moved == NULL)
+        {
+            return false;
+        }
+
+        // old array stays behind until reset()
+        std::size_t filled = (container->majorType == CborBase::TypeMap) ? 2 * container->content.container.count
+                                                                         : container->content.container.count;
+
+        if (filled > 0)
+        {
+            memcpy(moved, items, filled * sizeof(CborNode*));
+        }
+
+        container->content.container.items = moved;
+    }
+
+    container->content.container.capacity = larger;
+
+    return true;
+}
@@ -16,11 +16,19 @@
 
 #include "cborg/Cbore.h"
 #include "cborg/Cborg.h"
+#include "cborg/CborgFloat.h"
 
 #include <list>
 #include <string.h>
 #include <stdio.h>
 
+// slow paths stay out of line so the common paths need no stack frame
+#if defined(__GNUC__)
+#define CBORE_NOINLINE __attribute__((noinline))
+#else
+#define CBORE_NOINLINE
+#endif
+
 #if 0
 #include <stdio.h>
 #define DEBUG_PRINTF(...) { printf(__VA_ARGS__); }
@@ -28,22 +36,152 @@
 #define DEBUG_PRINTF(...)
 #endif
 
+namespace {
+    /*
+        Write header with the argument in size bytes, which may be more
+        than needed when a patched header keeps its reserved width.
+    */
+    inline void encodeHeader(uint8_t* pointer, uint8_t majorType, uint64_t value, uint8_t size)
+    {
+        uint8_t majorTypeHigh = majorType << 5;
+
+        // value fits in one byte
+        if (size == 1)
+        {
+            pointer[0] = majorTypeHigh | value;
+        }
+        // value fits in two bytes
+        else if (size == 2)
+        {
+            pointer[0] = majorTypeHigh | 24;
+            pointer[1] = value;
+        }
+        // value fits in three bytes
+        else if (size == 3)
+        {
+            pointer[0] = majorTypeHigh | 25;
+            pointer[1] = value >> 8;
+            pointer[2] = value;
+        }
+        // value fits in four bytes
+        else if (size == 5)
+        {
+            pointer[0] = majorTypeHigh | 26;
+            pointer[1] = value >> 24;
+            pointer[2] = value >> 16;
+            pointer[3] = value >> 8;
+            pointer[4] = value;
+        }
+        // value needs eight bytes
+        else
+        {
+            pointer[0] = majorTypeHigh | 27;
+
+            for (int idx = 1; idx < 9; idx++)
+            {
+                pointer[idx] = value >> (64 - 8 * idx);
+            }
+        }
+    }
+}
+
 
 Cbore::Cbore()
     :   cbor(NULL),
         currentLength(0),
-        maxLength(0)
+        maxLength(0),
+        floatMode(FloatAsGiven),
+        sink(NULL),
+        flushed(0),
+        referenceLength((std::size_t) -1),
+        overflow(false),
+        containerMode(ContainerIndefinite)
 {}
 
 Cbore::Cbore(uint8_t* _cbor, std::size_t _length)
     :   cbor(_cbor),
         currentLength(0),
-        maxLength(_length)
+        maxLength((_cbor) ? _length : 0),
+        floatMode(FloatAsGiven),
+        sink(NULL),
+        flushed(0),
+        referenceLength((std::size_t) -1),
+        overflow(false),
+        containerMode(ContainerIndefinite)
+{}
+
+Cbore::Cbore(CboreSink& _sink)
+    :   cbor(NULL),
+        currentLength(0),
+        maxLength(0),
+        floatMode(FloatAsGiven),
+        sink(&_sink),
+        flushed(0),
+        referenceLength((_sink.getReferenceLength() > 0) ? _sink.getReferenceLength() : (std::size_t) -1),
+        overflow(false),
+        containerMode(ContainerIndefinite)
 {}
 
 std::size_t Cbore::getLength() const
 {
-    return currentLength;
+    return flushed + currentLength;
+}
+
+bool Cbore::flush()
+{
+    return (sink == NULL) || refill(0);
+}
+
+bool Cbore::hasOverflow() const
+{
+    return overflow;
+}
+
+Cbore::Savepoint Cbore::savepoint() const
+{
+    Savepoint point;
+    point.length = flushed + currentLength;
+    point.levels = levels;
+    point.overflow = overflow;
+
+    return point;
+}
+
+bool Cbore::rollback(const Savepoint& point)
+{
+    // already passed on to the sink, or reset since
+    if ((point.length < flushed) || (point.length > flushed + currentLength))
+    {
+        return false;
+    }
+
+    // closing a patched container writes its header and may move its contents
+    for (std::size_t idx = 0; idx < point.levels.size(); idx++)
+    {
+        if ((point.levels[idx].mode == LevelPatch) || (point.levels[idx].mode == LevelCompact))
+        {
+            if ((idx >= levels.size()) || (levels[idx].position != point.levels[idx].position))
+            {
+                return false;
+            }
+        }
+    }
+
+    currentLength = point.length - flushed;
+    levels = point.levels;
+    overflow = point.overflow;
+
+    return true;
+}
+
+void Cbore::setFloatMode(FloatMode_t mode)
+{
+    floatMode = mode;
+}
+
+void Cbore::setContainerMode(ContainerMode_t mode)
+{
+    containerMode = mode;
 }
 
 /*****************************************************************************/
@@ -52,7 +190,7 @@ std::size_t Cbore::getLength() const
 
 Cbore& Cbore::tag(uint32_t tag)
 {
-    if ((cbor) && (itemSize(tag) <= (maxLength - currentLength)))
+    if (reserve(itemSize(tag)))
     {
         writeTypeAndValue(CborBase::TypeTag, tag);
     }
@@ -60,9 +198,59 @@ Cbore& Cbore::tag(uint32_t tag)
     return *this;
 }
 
+Cbore& Cbore::raw(const uint8_t* encoded, std::size_t length, std::size_t items)
+{
+    return writeRaw(encoded, length, items, true);
+}
+
+Cbore& Cbore::raw(const Cborg& subtree)
+{
+    const uint8_t* encoded = NULL;
+    uint32_t length = 0;
+
+    // malformed or truncated items are left out
+    if (!subtree.getCBOR(&encoded, &length))
+    {
+        return *this;
+    }
+
+    return writeRaw(encoded, length, 1, true);
+}
+
+Cbore& Cbore::slot(SlotType_t type, std::size_t* offset)
+{
+    *offset = flushed + currentLength;
+
+    if (type == SlotFloat)
+    {
+        return writeFloat(CborBase::TypeSingleFloat, 0);
+    }
+    else if (type == SlotDouble)
+    {
+        return writeFloat(CborBase::TypeDoubleFloat, 0);
+    }
+
+    // wider than needed for zero, setters store the full width
+    uint8_t size = (type == SlotInteger32) ? 5 : 9;
+
+    if (reserve(size))
+    {
+        encodeHeader(&cbor[currentLength], CborBase::TypeUnsigned, 0, size);
+        currentLength += size;
+    }
+
+    return (levels.size() > 0) ? counted() : *this;
+}
+
 Cbore& Cbore::end()
 {
-    if ((cbor) && (currentLength < maxLength))
+    // patched container, or indefinite container inside one
+    if (levels.size() > 0)
+    {
+        return closeContainer();
+    }
+
+    if (reserve(1))
     {
         cbor[currentLength++] = CborBase::TypeSpecial << 5 | CborBase::TypeIndefinite;
     }
@@ -74,104 +262,147 @@ Cbore& Cbore::end()
 /* Array creation                                                        */
 /*************************************************************************/
 
-// create indefinite array
+// create indefinite array, or one counted by end()
 Cbore& Cbore::array()
 {
-    if ((cbor) && (currentLength < maxLength))
-    {
-        cbor[currentLength++] = CborBase::TypeArray << 5 | CborBase::TypeIndefinite;
-    }
-
-    return *this;
+    return openContainer(CborBase::TypeArray);
 }
 
 // create arrray in array
 Cbore& Cbore::array(std::size_t items)
 {
-    if ((cbor) && (itemSize(items) <= (maxLength - currentLength)))
+    if (reserve(itemSize(items)))
     {
+        if (levels.size() > 0)
+        {
+            return openDefinite(CborBase::TypeArray, items);
+        }
+
         writeTypeAndValue(CborBase::TypeArray, items);
     }
 
     return *this;
 }
 
-/*************************************************************************/
-/* Array insertion                                                       */
-/*************************************************************************/
-
-// insert integer
-Cbore& Cbore::item(int32_t value)
+// create array of floats
+Cbore& Cbore::array(const float* values, std::size_t count)
 {
-    if (itemSize(value) <= (maxLength - currentLength))
+    array(count);
+
+    // convert to half precision and back in blocks, values that survive
+    // the round trip unchanged are written as half precision
+    const std::size_t block = 32;
+    uint16_t halves[block];
+    float widened[block];
+
+    for (std::size_t offset = 0; offset < count; offset += block)
     {
-        if (value < 0)
+        std::size_t size = (count - offset < block) ? count - offset : block;
+
+        if (floatMode == FloatShortest)
         {
-            writeTypeAndValue(CborBase::TypeNegative, -1 - value);
+            CborgFloat::floatToHalf(&values[offset], halves, size);
+            CborgFloat::halfToFloat(halves, widened, size);
         }
-        else
+
+        for (std::size_t idx = 0; idx < size; idx++)
         {
-            writeTypeAndValue(CborBase::TypeUnsigned, value);
+            uint32_t bits;
+            memcpy(&bits, &values[offset + idx], sizeof(bits));
+
+            if ((floatMode == FloatShortest) && (memcmp(&widened[idx], &bits, sizeof(bits)) == 0))
+            {
+                writeFloat(CborBase::TypeHalfFloat, halves[idx]);
+            }
+            else
+            {
+                writeFloat(CborBase::TypeSingleFloat, bits);
+            }
         }
     }
 
     return *this;
 }
 
+/*************************************************************************/
+/* Array insertion                                                       */
+/*************************************************************************/
+
 // insert simple type
 Cbore& Cbore::item(CborBase::SimpleType_t simpleType)
 {
-    if (currentLength < maxLength)
+    if (reserve(1))
     {
         cbor[currentLength++] = CborBase::TypeSpecial << 5 | simpleType;
     }
 
-    return *this;
+    return (levels.size() > 0) ? counted() : *this;
 }
 
-Cbore& Cbore::item(const uint8_t* bytes, std::size_t length)
+// insert float
+Cbore& Cbore::item(float value)
 {
-    if ((itemSize(length) + length) <= (maxLength - currentLength))
+    uint64_t bits = 0;
+
+    if (floatMode == FloatShortest)
     {
-        writeTypeAndValue(CborBase::TypeBytes, length);
-        writeBytes(bytes, length);
+        uint8_t simpleType = CborgFloat::shortest(value, &bits);
+
+        return writeFloat(simpleType, bits);
     }
 
-    return *this;
+    memcpy(&bits, &value, sizeof(value));
+
+    return writeFloat(CborBase::TypeSingleFloat, bits);
 }
 
-// write string, length
-Cbore& Cbore::item(const char* string, std::size_t length)
+Cbore& Cbore::item(double value)
 {
-    if ((itemSize(length) + length) <= (maxLength - currentLength))
+    uint64_t bits = 0;
+
+    if (floatMode == FloatShortest)
     {
-        writeTypeAndValue(CborBase::TypeString, length);
-        writeBytes((const uint8_t*) string, length);
+        uint8_t simpleType = CborgFloat::shortest(value, &bits);
+
+        return writeFloat(simpleType, bits);
     }
 
-    return *this;
+    memcpy(&bits, &value, sizeof(value));
+
+    return writeFloat(CborBase::TypeDoubleFloat, bits);
+}
+
+Cbore& Cbore::item(const uint8_t* bytes, std::size_t length)
+{
+    return writeString(CborBase::TypeBytes, bytes, length);
+}
+
+// write string, length
+Cbore& Cbore::item(const char* string, std::size_t length)
+{
+    return writeString(CborBase::TypeString, (const uint8_t*) string, length);
 }
 
 /*************************************************************************/
 /* Map creation                                                          */
 /*************************************************************************/
 
-// create indefinite map
+// create indefinite map, or one counted by end()
 Cbore& Cbore::map()
 {
-    if ((cbor) && (currentLength < maxLength))
-    {
-        cbor[currentLength++] = CborBase::TypeMap << 5 | CborBase::TypeIndefinite;
-    }
-
-    return *this;
+    return openContainer(CborBase::TypeMap);
 }
 
 // create map in array
 Cbore& Cbore::map(std::size_t items)
 {
-    if ((cbor) && (itemSize(items) <= (maxLength - currentLength)))
+    if (reserve(itemSize(items)))
     {
+        if (levels.size() > 0)
+        {
+            return openDefinite(CborBase::TypeMap, items);
+        }
+
         writeTypeAndValue(CborBase::TypeMap, items);
     }
 
@@ -182,198 +413,510 @@ Cbore& Cbore::map(std::size_t items)
 /* Map insertion - key                                                   */
 /*************************************************************************/
 
-// insert key as integer
-Cbore& Cbore::key(int32_t unit)
+// insert key as const char pointer with length
+Cbore& Cbore::key(const char* unit, std::size_t length)
+{
+    return writeString(CborBase::TypeString, (const uint8_t*) unit, length);
+}
+
+/*************************************************************************/
+/* Map insertion - value                                                 */
+/*************************************************************************/
+
+Cbore& Cbore::value(CborBase::SimpleType_t unit)
 {
-    if ((itemSize(unit)) <= (maxLength - currentLength))
+    if (reserve(1))
     {
-        if (unit < 0)
-        {
-            writeTypeAndValue(CborBase::TypeNegative, -1 - unit);
-        }
-        else
-        {
-            writeTypeAndValue(CborBase::TypeUnsigned, unit);
-        }
+        cbor[currentLength++] = CborBase::TypeSpecial << 5 | unit;
+    }
+
+    return (levels.size() > 0) ? counted() : *this;
+}
+
+Cbore& Cbore::value(float unit)
+{
+    return item(unit);
+}
+
+Cbore& Cbore::value(double unit)
+{
+    return item(unit);
+}
+
+Cbore& Cbore::value(const uint8_t* unit, std::size_t length)
+{
+    return writeString(CborBase::TypeBytes, unit, length);
+}
+
+Cbore& Cbore::value(const char* unit, std::size_t length)
+{
+    return writeString(CborBase::TypeString, (const uint8_t*) unit, length);
+}
+
+Cbore& Cbore::reset(bool resetBuffer) {
+    currentLength = 0;
+    flushed = 0;
+    overflow = false;
+
+    while (levels.size() > 0) {
+        levels.pop_back();
+    }
+
+    if (sink) {
+        cbor = NULL;
+        maxLength = 0;
+    } else if (resetBuffer && cbor) {
+        memset(cbor, 0x00, maxLength);
     }
 
     return *this;
 }
 
-// insert key as const char pointer with length
-Cbore& Cbore::key(const char* unit, std::size_t length)
+/*****************************************************************************/
+/* Helper Functions                                                          */
+/*****************************************************************************/
+
+// insert unsigned or negative integer, argument is -1 - value for negative
+Cbore& Cbore::writeInteger(bool negative, uint64_t argument)
+{
+    uint8_t size = itemSize(argument);
+
+    if (size > (maxLength - currentLength))
+    {
+        return refillInteger(negative, argument, size);
+    }
+
+    encodeHeader(&cbor[currentLength], (negative) ? CborBase::TypeNegative : CborBase::TypeUnsigned, argument, size);
+    currentLength += size;
+
+    return (levels.size() > 0) ? counted() : *this;
+}
+
+// insert half, single or double precision float given by its bits
+Cbore& Cbore::writeFloat(uint8_t simpleType, uint64_t bits)
 {
-    if ((itemSize(length) + length) <= (maxLength - currentLength))
+    std::size_t size = (simpleType == CborBase::TypeHalfFloat) ? 2
+                     : (simpleType == CborBase::TypeSingleFloat) ? 4 : 8;
+
+    if (size + 1 > (maxLength - currentLength))
     {
-        writeTypeAndValue(CborBase::TypeString, length);
-        writeBytes((const uint8_t*) unit, length);
+        return refillFloat(simpleType, bits, size + 1);
     }
 
-    return *this;
+    // local pointer, byte stores could alias the members
+    uint8_t* pointer = &cbor[currentLength];
+    pointer[0] = CborBase::TypeSpecial << 5 | simpleType;
+
+    for (std::size_t idx = size; idx > 0; idx--)
+    {
+        pointer[size + 1 - idx] = bits >> (8 * (idx - 1));
+    }
+
+    currentLength += size + 1;
+
+    return (levels.size() > 0) ? counted() : *this;
 }
 
-/*************************************************************************/
-/* Map insertion - value                                                 */
-/*************************************************************************/
+// insert byte or text string, without a sink nothing is written unless it fits
+Cbore& Cbore::writeString(CborBase::MajorType_t majorType, const uint8_t* source, std::size_t length)
+{
+    std::size_t header = itemSize(length);
+
+    // common case, header and payload fit in the window
+    if ((source) && (length <= (maxLength - currentLength)) && (header <= (maxLength - currentLength - length))
+        && (length < referenceLength))
+    {
+        writeTypeAndValue(majorType, length);
+
+        memcpy(&cbor[currentLength], source, length);
+        currentLength += length;
+    }
+    else if (fits(header, length))
+    {
+        writeTypeAndValue(majorType, length);
+        writeBytes(source, length);
+    }
 
-Cbore& Cbore::value(int32_t unit)
+    return (levels.size() > 0) ? counted() : *this;
+}
+
+// pre-encoded items, constants are always copied since the array may be
+// a temporary
+CBORE_NOINLINE Cbore& Cbore::writeRaw(const uint8_t* encoded, std::size_t length, std::size_t items, bool byReference)
 {
-    if ((itemSize(unit)) <= (maxLength - currentLength))
+    if ((encoded != NULL) && fits(0, length))
     {
-        if (unit < 0)
+        if ((length <= (maxLength - currentLength)) && (!byReference || (length < referenceLength)))
         {
-            writeTypeAndValue(CborBase::TypeNegative, -1 - unit);
+            memcpy(&cbor[currentLength], encoded, length);
+            currentLength += length;
         }
         else
         {
-            writeTypeAndValue(CborBase::TypeUnsigned, unit);
+            writeSplit(encoded, length, byReference);
+        }
+
+        for (std::size_t idx = 0; (idx < items) && (levels.size() > 0); idx++)
+        {
+            counted();
         }
     }
 
     return *this;
 }
 
-Cbore& Cbore::value(CborBase::SimpleType_t unit)
+// insert tag and byte string, without a sink nothing is written unless both fit
+Cbore& Cbore::writeTyped(uint32_t tag, const void* values, std::size_t length)
 {
-    if (currentLength < maxLength)
+    if (fits(itemSize(tag) + itemSize(length), length))
     {
-        cbor[currentLength++] = CborBase::TypeSpecial << 5 | unit;
+        writeTypeAndValue(CborBase::TypeTag, tag);
+        writeTypeAndValue(CborBase::TypeBytes, length);
+        writeBytes((const uint8_t*) values, length);
     }
 
-    return *this;
+    return (levels.size() > 0) ? counted() : *this;
 }
 
-Cbore& Cbore::value(const uint8_t* unit, std::size_t length)
+// window is full, the item is dropped unless the sink makes room
+CBORE_NOINLINE bool Cbore::grow(std::size_t required)
 {
-    if ((itemSize(length) + length) <= (maxLength - currentLength))
+    if (refill(required) && (required <= (maxLength - currentLength)))
     {
-        writeTypeAndValue(CborBase::TypeBytes, length);
-        writeBytes(unit, length);
+        return true;
     }
 
-    return *this;
+    overflow = true;
+
+    return false;
 }
 
-Cbore& Cbore::value(const char* unit, std::size_t length)
+// ask the sink for a window with room for required bytes, or to take the
+// rest of the document when required is zero
+CBORE_NOINLINE bool Cbore::refill(std::size_t required)
 {
-    if ((itemSize(length) + length) <= (maxLength - currentLength))
+    if (sink == NULL)
     {
-        writeTypeAndValue(CborBase::TypeString, length);
-        writeBytes((const uint8_t*) unit, length);
+        return false;
     }
 
-    return *this;
+    std::size_t used = currentLength;
+    bool result = sink->next(&cbor, &maxLength, &used, required, kept());
+
+    // bytes the sink took out of the window
+    flushed += currentLength - used;
+    currentLength = used;
+
+    // output is lost when the sink fails
+    overflow = overflow || !result;
+
+    return result;
 }
 
-Cbore& Cbore::reset(bool resetBuffer) {
-    currentLength = 0;
-    if(resetBuffer) {
-        memset(cbor, 0x00, maxLength);
+uint8_t Cbore::itemSize(uint64_t argument)
+{
+    return CboreSize::header(argument);
+}
+
+uint8_t Cbore::writeTypeAndValue(CborBase::MajorType_t majorType, uint64_t value)
+{
+    if (majorType < CborBase::TypeSpecial)
+    {
+        uint8_t size = itemSize(value);
+
+        if (size > (maxLength - currentLength))
+        {
+            return refillTypeAndValue(majorType, value, size);
+        }
+
+        encodeHeader(&cbor[currentLength], majorType, value, size);
+        currentLength += size;
+
+        return size;
     }
 
-    return *this;
+    return 0;
+}
+
+// copy payload, with a sink it is split across as many windows as needed
+// or passed by reference
+std::size_t Cbore::writeBytes(const uint8_t* source, std::size_t length)
+{
+    if ((source == NULL) || (length > (maxLength - currentLength)) || (length >= referenceLength))
+    {
+        return writeSplit(source, length);
+    }
+
+    memcpy(&cbor[currentLength], source, length);
+    currentLength += length;
+
+    return length;
+}
+
+// slow paths, the window is full
+CBORE_NOINLINE Cbore& Cbore::refillFloat(uint8_t simpleType, uint64_t bits, std::size_t required)
+{
+    return (reserve(required)) ? writeFloat(simpleType, bits) : *this;
+}
+
+CBORE_NOINLINE Cbore& Cbore::refillInteger(bool negative, uint64_t argument, std::size_t required)
+{
+    return (reserve(required)) ? writeInteger(negative, argument) : *this;
+}
+
+CBORE_NOINLINE uint8_t Cbore::refillTypeAndValue(CborBase::MajorType_t majorType, uint64_t value, std::size_t required)
+{
+    return (reserve(required)) ? writeTypeAndValue(majorType, value) : 0;
+}
+
+CBORE_NOINLINE std::size_t Cbore::writeSplit(const uint8_t* source, std::size_t length, bool byReference)
+{
+    if (source == NULL)
+    {
+        return 0;
+    }
+
+    // large payload, the sink keeps a pointer instead of a copy
+    if (byReference && (length >= referenceLength))
+    {
+        std::size_t used = currentLength;
+
+        if (sink->reference(source, length, &cbor, &maxLength, &used, kept()))
+        {
+            flushed += currentLength - used + length;
+            currentLength = used;
+
+            return length;
+        }
+    }
+
+    std::size_t written = 0;
+
+    while (written < length)
+    {
+        std::size_t room = maxLength - currentLength;
+
+        if (room == 0)
+        {
+            if (!refill(length - written) || (maxLength == currentLength))
+            {
+                overflow = true;
+
+                break;
+            }
+
+            continue;
+        }
+
+        std::size_t part = (length - written < room) ? length - written : room;
+
+        memcpy(&cbor[currentLength], &source[written], part);
+        currentLength += part;
+        written += part;
+    }
+
+    return written;
 }
 
 /*****************************************************************************/
-/* Helper Functions                                                          */
+/* Container tracking                                                        */
 /*****************************************************************************/
 
-uint8_t Cbore::itemSize(int32_t item)
-{
-    item = (item < 0) ? -1 - item : item;
+/*
+    Once a patched container is open, every container is pushed onto levels
+    so end() knows which container it closes, and every item is counted
+    against the innermost container when it begins: patched containers
+    count up, definite containers count down and are popped once they are
+    down to zero and their last item is complete.
+*/
 
-    if (item <= 23)
+// bytes from the oldest patched header on, they must stay in the window
+std::size_t Cbore::kept() const
+{
+    if ((levels.size() > 0) && (levels[0].position >= flushed))
     {
-        return 1;
+        return flushed + currentLength - levels[0].position;
     }
-    else if (item <= 0xFF)
+
+    return 0;
+}
+
+// scalar item at the current level
+CBORE_NOINLINE Cbore& Cbore::counted()
+{
+    begin();
+    closeDefinite();
+
+    return *this;
+}
+
+void Cbore::begin()
+{
+    Level_t& level = levels.back();
+
+    if (level.mode == LevelDefinite)
     {
-        return 2;
+        level.units--;
     }
-    else if (item <= 0xFFFF)
+    else if (level.mode != LevelIndefinite)
     {
-        return 3;
+        level.units++;
     }
-    else
+}
+
+void Cbore::closeDefinite()
+{
+    while ((levels.size() > 0) && (levels.back().mode == LevelDefinite) && (levels.back().units == 0))
     {
-        return 5;
+        levels.pop_back();
     }
 }
 
-uint8_t Cbore::writeTypeAndValue(CborBase::MajorType_t majorType, uint32_t value)
+Cbore& Cbore::openContainer(CborBase::MajorType_t majorType)
 {
-    if (cbor)
+    if (containerMode == ContainerIndefinite)
     {
-        if (majorType < CborBase::TypeSpecial)
+        if ((levels.size() > 0) && (levels.size() >= levels.capacity()))
         {
-            uint8_t majorTypeHigh = majorType << 5;
+            overflow = true;
 
-            uint32_t remainingLength = maxLength - currentLength;
+            return *this;
+        }
 
-            // value fits in one byte
-            if (value <= 23)
-            {
-                if (remainingLength >= 1)
-                {
-                    cbor[currentLength++] = majorTypeHigh | value;
+        if (reserve(1))
+        {
+            cbor[currentLength++] = majorType << 5 | CborBase::TypeIndefinite;
 
-                    return 1;
-                }
-            }
-            // value fits in two bytes
-            else if (value <= 0xFF)
+            if (levels.size() > 0)
             {
-                if (remainingLength >= 2)
-                {
-                    cbor[currentLength++] = majorTypeHigh | 24;
-                    cbor[currentLength++] = value;
+                begin();
 
-                    return 2;
-                }
+                Level_t level = { 0, 0, (uint8_t) majorType, LevelIndefinite };
+                levels.push_back(level);
             }
-            // value fits in three bytes
-            else if (value <= 0xFFFF)
-            {
-                if (remainingLength >= 3)
-                {
-                    cbor[currentLength++] = majorTypeHigh | 25;
-                    cbor[currentLength++] = value >> 8;
-                    cbor[currentLength++] = value;
-
-                    return 3;
-                }
-            }
-            // value fits in four bytes
-            else
+        }
+    }
+    else
+    {
+        // header with two byte count, filled in by end()
+        if (levels.size() >= levels.capacity())
+        {
+            overflow = true;
+        }
+        else if (reserve(3))
+        {
+            if (levels.size() > 0)
             {
-                if (remainingLength >= 5)
-                {
-                    cbor[currentLength++] = majorTypeHigh | 26;
-                    cbor[currentLength++] = value >> 24;
-                    cbor[currentLength++] = value >> 16;
-                    cbor[currentLength++] = value >> 8;
-                    cbor[currentLength++] = value;
-
-                    return 5;
-                }
+                begin();
             }
+
+            Level_t level = { flushed + currentLength, 0, (uint8_t) majorType,
+                              (uint8_t) ((containerMode == ContainerCompact) ? LevelCompact : LevelPatch) };
+            levels.push_back(level);
+
+            encodeHeader(&cbor[currentLength], majorType, 0, 3);
+            currentLength += 3;
         }
     }
 
-    return 0;
+    return *this;
 }
 
-uint32_t Cbore::writeBytes(const uint8_t* source, uint32_t length)
+// definite container inside a patched one, header already reserved
+Cbore& Cbore::openDefinite(CborBase::MajorType_t majorType, std::size_t items)
 {
-    if ((cbor) && (source) && (length <= (maxLength - currentLength)))
+    if ((items > 0) && (levels.size() >= levels.capacity()))
     {
-        memcpy(&cbor[currentLength], source, length);
-        currentLength += length;
+        overflow = true;
 
-        return length;
+        return *this;
     }
 
-    return 0;
+    writeTypeAndValue(majorType, items);
+
+    if (items > 0)
+    {
+        begin();
+
+        Level_t level = { 0, (majorType == CborBase::TypeMap) ? 2 * items : items, (uint8_t) majorType, LevelDefinite };
+        levels.push_back(level);
+
+        return *this;
+    }
+
+    // empty container is complete right away
+    return counted();
+}
+
+Cbore& Cbore::closeContainer()
+{
+    Level_t level = levels.back();
+
+    if (level.mode == LevelIndefinite)
+    {
+        if (!reserve(1))
+        {
+            return *this;
+        }
+
+        cbor[currentLength++] = CborBase::TypeSpecial << 5 | CborBase::TypeIndefinite;
+    }
+    else if (level.mode != LevelDefinite)
+    {
+        std::size_t count = (level.majorType == CborBase::TypeMap) ? level.units / 2 : level.units;
+        uint8_t size = itemSize(count);
+
+        if ((size < 3) && (level.mode != LevelCompact))
+        {
+            // count fits the reserved width, nothing moves
+            size = 3;
+        }
+
+        if (level.position < flushed)
+        {
+            // the sink discarded the header instead of keeping it, e.g.,
+            // when measuring, only the length changes
+            flushed = flushed + size - 3;
+        }
+        else if (size > 3)
+        {
+            // count needs a longer header, move the contents up
+            if (!reserve(size - 3))
+            {
+                return *this;
+            }
+
+            std::size_t header = level.position - flushed;
+
+            memmove(&cbor[header + size], &cbor[header + 3], currentLength - header - 3);
+            currentLength += size - 3;
+        }
+        else if (size < 3)
+        {
+            // shortest header, move the contents down
+            std::size_t header = level.position - flushed;
+
+            memmove(&cbor[header + size], &cbor[header + 3], currentLength - header - 3);
+            currentLength -= 3 - size;
+        }
+
+        if (level.position >= flushed)
+        {
+            encodeHeader(&cbor[level.position - flushed], level.majorType, count, size);
+        }
+    }
+    else
+    {
+        // definite containers end by themselves
+        return *this;
+    }
+
+    levels.pop_back();
+
+    // the closed container may be the last item of a definite one
+    closeDefinite();
+
+    return *this;
 }
 
 /*****************************************************************************/
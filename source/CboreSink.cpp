@@ -0,0 +1,290 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "cborg/CboreSink.h"
+
+#include <string.h>
+
+/*****************************************************************************/
+/* Vector                                                                    */
+/*****************************************************************************/
+
+CboreVectorSink::CboreVectorSink(std::vector<uint8_t>& _output)
+    :   output(_output)
+{
+    output.clear();
+}
+
+bool CboreVectorSink::next(uint8_t** window, std::size_t* size, std::size_t* used, std::size_t required, std::size_t)
+{
+    if (required == 0)
+    {
+        // document complete, drop the unused tail
+        output.resize(*used);
+    }
+    else
+    {
+        if (required > output.max_size() - *used)
+        {
+            return false;
+        }
+
+        // grow geometrically so streaming large payloads stays linear
+        std::size_t capacity = 2 * output.size();
+
+        if (capacity < *used + required)
+        {
+            capacity = *used + required;
+        }
+
+        if (capacity < 64)
+        {
+            capacity = 64;
+        }
+
+        output.resize(capacity);
+    }
+
+    *window = (output.size() > 0) ? &output[0] : NULL;
+    *size = output.size();
+
+    return true;
+}
+
+/*****************************************************************************/
+/* Blocks                                                                    */
+/*****************************************************************************/
+
+CboreBlockSink::CboreBlockSink(std::size_t _blockSize)
+    :   blockSize(_blockSize)
+{}
+
+bool CboreBlockSink::next(uint8_t** window, std::size_t* size, std::size_t* used, std::size_t required, std::size_t keep)
+{
+    if (blockSize == 0)
+    {
+        return false;
+    }
+
+    // the window is the last block unless the encoder was reset
+    bool current = (*window != NULL) && (blocks.size() > 0);
+
+    if (required == 0)
+    {
+        if (current)
+        {
+            blocks.back().resize(*used);
+        }
+
+        *size = *used;
+
+        return true;
+    }
+
+    blocks.push_back(std::vector<uint8_t>(blockSize));
+
+    if (current)
+    {
+        std::vector<uint8_t>& previous = blocks[blocks.size() - 2];
+
+        if (keep > 0)
+        {
+            memcpy(&blocks.back()[0], &previous[*used - keep], keep);
+        }
+
+        previous.resize(*used - keep);
+    }
+
+    *window = &blocks.back()[0];
+    *size = blockSize;
+    *used = (current) ? keep : 0;
+
+    return true;
+}
+
+std::size_t CboreBlockSink::getBlocks() const
+{
+    return blocks.size();
+}
+
+const std::vector<uint8_t>& CboreBlockSink::getBlock(std::size_t index) const
+{
+    return blocks[index];
+}
+
+void CboreBlockSink::clear()
+{
+    blocks.clear();
+}
+
+/*****************************************************************************/
+/* Callback                                                                  */
+/*****************************************************************************/
+
+CboreCallbackSink::CboreCallbackSink(uint8_t* _buffer, std::size_t _length, Write_t _write, void* _context)
+    :   buffer(_buffer),
+        length(_length),
+        write(_write),
+        context(_context)
+{}
+
+bool CboreCallbackSink::next(uint8_t** window, std::size_t* size, std::size_t* used, std::size_t, std::size_t keep)
+{
+    if ((buffer == NULL) || (write == NULL))
+    {
+        return false;
+    }
+
+    if ((*window == NULL) || (*used == 0))
+    {
+        *window = buffer;
+        *size = length;
+        *used = 0;
+
+        return true;
+    }
+
+    if (*used > keep)
+    {
+        if (!write(*window, *used - keep, context))
+        {
+            return false;
+        }
+
+        memmove(buffer, &(*window)[*used - keep], keep);
+    }
+
+    *window = buffer;
+    *size = length;
+    *used = keep;
+
+    return true;
+}
+
+/*****************************************************************************/
+/* Gather list                                                               */
+/*****************************************************************************/
+
+CboreGatherSink::CboreGatherSink(uint8_t* _buffer, std::size_t _length, std::size_t _referenceLength)
+    :   buffer(_buffer),
+        length(_length),
+        offset(0),
+        referenceLength(_referenceLength)
+{}
+
+bool CboreGatherSink::next(uint8_t** window, std::size_t* size, std::size_t* used, std::size_t, std::size_t keep)
+{
+    if (buffer == NULL)
+    {
+        return false;
+    }
+
+    std::size_t kept = 0;
+
+    // the used part of the window becomes a segment, the rest of the
+    // buffer is the next window and starts with the kept bytes
+    if ((*window != NULL) && (*used > 0))
+    {
+        kept = (keep < *used) ? keep : *used;
+
+        if (*used > kept)
+        {
+            append(*window, *used - kept);
+            offset += *used - kept;
+        }
+    }
+
+    *window = &buffer[offset];
+    *size = length - offset;
+    *used = kept;
+
+    return true;
+}
+
+std::size_t CboreGatherSink::getReferenceLength() const
+{
+    return referenceLength;
+}
+
+bool CboreGatherSink::reference(const uint8_t* data, std::size_t dataLength,
+                                uint8_t** window, std::size_t* size, std::size_t* used, std::size_t keep)
+{
+    // the kept bytes would have to come before the payload
+    if ((keep > 0) || !next(window, size, used, 0, 0))
+    {
+        return false;
+    }
+
+    append(data, dataLength);
+
+    return true;
+}
+
+const CborgSegment* CboreGatherSink::getSegments() const
+{
+    return (segments.size() > 0) ? &segments[0] : NULL;
+}
+
+std::size_t CboreGatherSink::getCount() const
+{
+    return segments.size();
+}
+
+void CboreGatherSink::clear()
+{
+    offset = 0;
+    segments.clear();
+}
+
+void CboreGatherSink::append(const uint8_t* data, std::size_t dataLength)
+{
+    // contiguous with the last segment, e.g., the window after a flush
+    if ((segments.size() > 0) && (segments.back().data + segments.back().length == data))
+    {
+        segments.back().length += dataLength;
+    }
+    else
+    {
+        CborgSegment segment = { data, dataLength };
+        segments.push_back(segment);
+    }
+}
+
+/*****************************************************************************/
+/* Count                                                                     */
+/*****************************************************************************/
+
+bool CboreCountSink::next(uint8_t** window, std::size_t* size, std::size_t* used, std::size_t, std::size_t)
+{
+    // everything is discarded, kept bytes included
+    *window = scratch;
+    *size = sizeof(scratch);
+    *used = 0;
+
+    return true;
+}
+
+std::size_t CboreCountSink::getReferenceLength() const
+{
+    return sizeof(scratch) / 4;
+}
+
+bool CboreCountSink::reference(const uint8_t*, std::size_t,
+                               uint8_t** window, std::size_t* size, std::size_t* used, std::size_t keep)
+{
+    return next(window, size, used, 0, keep);
+}
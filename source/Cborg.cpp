@@ -15,9 +15,12 @@
  */
 
 #include "cborg/Cborg.h"
+#include "cborg/CborgTraverse.h"
+#include "cborg/CborgPath.h"
+#include "cborg/CborgFloat.h"
 
-#include <list>
 #include <stdio.h>
+#include <string.h>
 #include <limits>
 #include <cinttypes>
 
@@ -28,796 +31,773 @@
 #define DEBUG_PRINTF(...)
 #endif
 
-template<typename T>
-typename std::enable_if<std::is_integral<T>::value, T>::type  maxOf(T /* var_to_maximize */) {
-    return std::numeric_limits<T>::max();
-}
+namespace {
+    // initial byte of the break marker ending indefinite containers
+    const uint8_t breakByte = CborBase::TypeSpecial << 5 | CborBase::TypeIndefinite;
 
-Cborg::Cborg()
-    :   cbor(NULL),
-        maxLength(0)
-{}
+    // initial byte of half precision floats
+    const uint8_t halfByte = CborBase::TypeSpecial << 5 | CborBase::TypeHalfFloat;
 
-Cborg::Cborg(const uint8_t* _cbor, std::size_t _length)
-    :   cbor(_cbor),
-        maxLength(_length)
-{}
-
-
-bool Cborg::getCBOR(const uint8_t** pointer, uint32_t* length)
-{
-    // decode current header
-    CborgHeader head;
-    head.decode(cbor);
-
-    uint8_t type = head.getMajorType();
-    uint8_t simple = head.getMinorType();
+    // skip one item, without any checks if the buffer has been validated
+    bool skipItem(const uint8_t* cbor, std::size_t maxLength, bool validated, std::size_t* length)
+    {
+        if (validated)
+        {
+            *length = CborgTraverse::skipUnchecked(cbor);
 
-    *pointer = cbor;
+            return true;
+        }
 
-    if (type == CborBase::TypeUnassigned)
-    {
-        return false;
+        return (CborgTraverse::skip(cbor, maxLength, length) == CborgTraverse::StatusOk);
     }
-    else if ((type == CborBase::TypeMap) || (type == CborBase::TypeArray)
-        || (((type == CborBase::TypeBytes) || (type == CborBase::TypeString))
-                    && (simple == CborBase::TypeIndefinite)))
-    {
-        // list keeps track of the current level
-        std::list<uint32_t> list;
-
-        // skip first header
-        std::size_t progress = head.getLength();
-        uint32_t units = head.getValue();
 
-        // maps contain key-value pairs, double the number of units in container
-        if (type == CborBase::TypeMap)
-        {
-            units *= 2;
-        }
-        else if (simple == CborBase::TypeIndefinite)
-        {
-            units = maxOf(units);
-        }
+    // keep value of first matching key
+    class CborgSingleKey
+    {
+    public:
+        CborgSingleKey(const CborgKey& _key)
+            :   key(_key)
+        {}
 
-        // iterate through cbor encoded buffer
-        // stop when maximum length is reached or
-        // the current container is finished
-        while (progress < maxLength)
+        bool pair(const uint8_t* pointer, const CborgHeader& head, const Cborg& value)
         {
-            // decrement unit count unless set to indefinite
-            if (units != maxOf(units))
+            if (key.matches(pointer, head))
             {
-                units--;
+                result = value;
+
+                return false;
             }
 
-            // decode header for cbor object currently pointed to
-            head.decode(&cbor[progress]);
+            return true;
+        }
 
-            type = head.getMajorType();
-            simple = head.getMinorType();
+        const CborgKey& key;
+        Cborg result;
+    };
 
-            // if object is a container type (map or array), push remaining units onto the stack (list)
-            // and set units to the number of elements in the new container.
-            if (type == CborBase::TypeMap)
-            {
-                if (simple == CborBase::TypeIndefinite)
-                {
-                    list.push_back(units);
-                    units = maxOf(units);
-                }
-                else if (head.getValue() > 0)
-                {
-                    list.push_back(units);
-                    units = 2 * head.getValue();
-                }
-            }
-            else if (type == CborBase::TypeArray)
-            {
-                if (simple == CborBase::TypeIndefinite)
-                {
-                    list.push_back(units);
-                    units = maxOf(units);
-                }
-                else if (head.getValue() > 0)
-                {
-                    list.push_back(units);
-                    units = head.getValue();
-                }
-            }
-            else if (((type == CborBase::TypeBytes) || (type == CborBase::TypeString))
-                    && (simple == CborBase::TypeIndefinite))
-            {
-                list.push_back(units);
-                units = maxOf(units);
-            }
+    /*
+        Print every item with indentation matching its depth.
+    */
+    class CborgPrinter
+    {
+    public:
+        bool item(const uint8_t* pointer, const CborgHeader& head, std::size_t depth)
+        {
+            uint32_t tag = head.getTag();
+            uint8_t type = head.getMajorType();
+            uint8_t simple = head.getMinorType();
 
-            // increment progress based on cbor object size
-            if (((type == CborBase::TypeBytes) || (type == CborBase::TypeString))
-                    && (simple != CborBase::TypeIndefinite))
+            for (std::size_t indent = 0; indent < depth; indent++)
             {
-                progress += head.getLength() + head.getValue();
+                printf("\t");
             }
-            else
+
+            /* semantic tag */
+            if (tag != CborBase::TypeUnassigned)
             {
-                progress += head.getLength();
+                printf("[%" PRIu32 "] ", tag);
             }
 
-            // finished processing all elements in the current container object
-            // step back up one level by popping remaining elements from the stack (list)
-            // do it in a while loop since we might have to step back up multiple times
-            while ((units == 0) || ((type == CborBase::TypeSpecial) && (simple == CborBase::TypeIndefinite)))
+            switch(type)
             {
-                type = CborBase::TypeSpecial;
-                simple = CborBase::TypeNull;
+                case CborBase::TypeUnsigned:
+                    printf("%" PRIu64 "\r\n", head.getValue());
+                    break;
 
-                if (list.size() > 0)
-                {
-                    // pop from stack
-                    units = list.back();
-                    list.pop_back();
-                }
-                else
-                {
-                    // stack is empty, means we have reached the end of the current container
-                    *length = progress;
+                case CborBase::TypeNegative:
+                    // -1 - value does not fit in int64_t for the largest values
+                    if (head.getValue() < std::numeric_limits<uint64_t>::max())
+                    {
+                        printf("-%" PRIu64 "\r\n", head.getValue() + 1);
+                    }
+                    else
+                    {
+                        printf("-18446744073709551616\r\n");
+                    }
+                    break;
 
-                    return true;
-                }
+                case CborBase::TypeBytes:
+                    if (simple == CborBase::TypeIndefinite)
+                    {
+                        printf("Bytes:\r\n");
+                    }
+                    else
+                    {
+                        for (std::size_t idx = 0; idx < head.getValue(); idx++)
+                        {
+                            printf("%02X", pointer[head.getLength() + idx]);
+                        }
+                        printf("\r\n");
+                    }
+                    break;
+
+                case CborBase::TypeString:
+                    if (simple == CborBase::TypeIndefinite)
+                    {
+                        printf("String:\r\n");
+                    }
+                    else
+                    {
+                        for (std::size_t idx = 0; idx < head.getValue(); idx++)
+                        {
+                            printf("%c", pointer[head.getLength() + idx]);
+                        }
+                        printf("\r\n");
+                    }
+                    break;
+
+                /* container object */
+                case CborBase::TypeArray:
+                    if (simple == CborBase::TypeIndefinite)
+                    {
+                        printf("Array:\r\n");
+                    }
+                    else
+                    {
+                        printf("Array: %" PRIu64 "\r\n", head.getValue());
+                    }
+                    break;
+
+                case CborBase::TypeMap:
+                    if (simple == CborBase::TypeIndefinite)
+                    {
+                        printf("Map:\r\n");
+                    }
+                    else
+                    {
+                        printf("Map: %" PRIu64 "\r\n", head.getValue());
+                    }
+                    break;
+
+                case CborBase::TypeSpecial:
+                    if (simple == CborBase::TypeTrue)
+                    {
+                        printf("true\r\n");
+                    }
+                    else if (simple == CborBase::TypeFalse)
+                    {
+                        printf("false\r\n");
+                    }
+                    else if (simple == CborBase::TypeNull)
+                    {
+                        printf("null\r\n");
+                    }
+                    else if (simple == CborBase::TypeUndefined)
+                    {
+                        printf("undefined\r\n");
+                    }
+                    else if ((simple == CborBase::TypeHalfFloat)
+                             || (simple == CborBase::TypeSingleFloat)
+                             || (simple == CborBase::TypeDoubleFloat))
+                    {
+                        double value = 0;
+                        CborgFloat::widen(simple, head.getValue(), &value);
+
+                        printf("%g\r\n", value);
+                    }
+                    break;
+
+                default:
+                    printf("error\r\n");
+                    return false;
             }
+
+            return true;
         }
 
-        return false;
+        void leave(const uint8_t*, std::size_t)
+        {}
+    };
+}
+
+/*****************************************************************************/
+/* Key                                                                       */
+/*****************************************************************************/
+
+CborgKey::CborgKey(int32_t _key)
+    :   string(NULL),
+        integer(_key),
+        length(0)
+{}
+
+CborgKey::CborgKey(const char* _key, std::size_t _keyLength)
+    :   string(_key),
+        integer(0),
+        length(_keyLength)
+{}
+
+bool CborgKey::matches(const uint8_t* pointer, const CborgHeader& head) const
+{
+    // payload follows the header
+    class Contiguous
+    {
+    public:
+        Contiguous(const uint8_t* _pointer, const CborgHeader& _head)
+            :   pointer(_pointer),
+                head(_head)
+        {}
+
+        bool operator()(const char* string, std::size_t length) const
+        {
+            return (memcmp(string, &pointer[head.getLength()], length) == 0);
+        }
+
+    private:
+        const uint8_t* pointer;
+        const CborgHeader& head;
+    };
+
+    return matches(head, Contiguous(pointer, head));
+}
+
+/*****************************************************************************/
+/* Decoder                                                                   */
+/*****************************************************************************/
+
+Cborg::Cborg()
+    :   cbor(NULL),
+        maxLength(0),
+        validated(false)
+{}
+
+Cborg::Cborg(const uint8_t* _cbor, std::size_t _length)
+    :   cbor(_cbor),
+        maxLength(_length),
+        validated(false)
+{}
+
+Cborg::Cborg(const uint8_t* _cbor, std::size_t _length, bool _validated)
+    :   cbor(_cbor),
+        maxLength(_length),
+        validated(_validated)
+{}
+
+Cborg Cborg::validate(const uint8_t* cbor, std::size_t maxLength)
+{
+    std::size_t length = 0;
+
+    if (CborgTraverse::validate(cbor, maxLength, &length) == CborgTraverse::StatusOk)
+    {
+        // only the validated item is kept
+        return Cborg(cbor, length, true);
     }
-    else if ((type == CborBase::TypeBytes) || (type == CborBase::TypeString))
+
+    return Cborg(NULL, 0);
+}
+
+bool Cborg::isValidated() const
+{
+    return validated;
+}
+
+
+bool Cborg::getCBOR(const uint8_t** pointer, uint32_t* length) const
+{
+    std::size_t progress = 0;
+
+    *pointer = cbor;
+
+    // use getCBORLength() for items beyond 32 bits
+    if (skipItem(cbor, maxLength, validated, &progress)
+        && (progress <= std::numeric_limits<uint32_t>::max()))
     {
-        // return header and length
-        *length = head.getLength() + head.getValue();
+        *length = progress;
+
+        return true;
     }
-    else
+
+    return false;
+}
+
+std::size_t Cborg::getCBORLength() const
+{
+    std::size_t progress = 0;
+
+    if (skipItem(cbor, maxLength, validated, &progress))
     {
-        // return header
-        *length = head.getLength();
+        return progress;
     }
 
-    return true;
+    return 0;
 }
 
-uint32_t Cborg::getCBORLength()
+/*
+    Walk the key-value pairs on the top level of the map.
+    For each pair match.pair(key, head, value) is called with
+    the decoded key and a Cborg object for the value; stop when it
+    returns false.
+*/
+template <typename Match>
+void Cborg::findPairs(Match& match) const
 {
-    // decode current header
     CborgHeader head;
-    head.decode(cbor);
+    head.decode(cbor, maxLength);
 
-    uint8_t type = head.getMajorType();
-    uint8_t simple = head.getMinorType();
-
-    if (type == CborBase::TypeUnassigned)
+    // only continue if type is Cbor Map
+    if (head.getMajorType() != CborBase::TypeMap)
     {
-        return 0;
+        return;
     }
-    else if ((type == CborBase::TypeMap) || (type == CborBase::TypeArray)
-        || (((type == CborBase::TypeBytes) || (type == CborBase::TypeString))
-                    && (simple == CborBase::TypeIndefinite)))
+
+    bool indefinite = (head.getMinorType() == CborBase::TypeIndefinite);
+    std::size_t units = (std::size_t) head.getValue();
+
+    // skip map header
+    std::size_t progress = head.getLength();
+
+    // stop when maximum length is reached or the current map is finished
+    while ((indefinite || (units > 0)) && (progress < maxLength))
     {
-        // list keeps track of the current level
-        std::list<uint32_t> list;
+        if (indefinite && (cbor[progress] == breakByte))
+        {
+            break;
+        }
 
-        // skip first header
-        std::size_t progress = head.getLength();
-        uint32_t units = head.getValue();
+        const uint8_t* key = &cbor[progress];
 
-        // maps contain key-value pairs, double the number of units in container
-        if (type == CborBase::TypeMap)
+        // skip key, the key header is within bounds once it has been skipped
+        std::size_t length = 0;
+
+        if (!skipItem(key, maxLength - progress, validated, &length))
         {
-            units *= 2;
+            break;
         }
-        else if (simple == CborBase::TypeIndefinite)
+
+        head.decode(key);
+
+        progress += length;
+
+        if ((progress >= maxLength)
+            || (!match.pair(key, head, Cborg(&cbor[progress], maxLength - progress, validated))))
         {
-            units = maxOf(units);
+            break;
         }
 
-        // iterate through cbor encoded buffer
-        // stop when maximum length is reached or
-        // the current container is finished
-        while (progress < maxLength)
+        // skip value
+        if (!skipItem(&cbor[progress], maxLength - progress, validated, &length))
         {
-            // decrement unit count unless set to indefinite
-            if (units != maxOf(units))
-            {
-                units--;
-            }
+            break;
+        }
 
-            // decode header for cbor object currently pointed to
-            head.decode(&cbor[progress]);
+        progress += length;
+        units--;
+    }
+}
 
-            type = head.getMajorType();
-            simple = head.getMinorType();
+Cborg Cborg::find(int32_t key) const
+{
+    CborgKey match(key);
+    CborgSingleKey single(match);
 
-            // if object is a container type (map or array), push remaining units onto the stack (list)
-            // and set units to the number of elements in the new container.
-            if (type == CborBase::TypeMap)
-            {
-                if (simple == CborBase::TypeIndefinite)
-                {
-                    list.push_back(units);
-                    units = maxOf(units);
-                }
-                else if (head.getValue() > 0)
-                {
-                    list.push_back(units);
-                    units = 2 * head.getValue();
-                }
-            }
-            else if (type == CborBase::TypeArray)
-            {
-                if (simple == CborBase::TypeIndefinite)
-                {
-                    list.push_back(units);
-                    units = maxOf(units);
-                }
-                else if (head.getValue() > 0)
-                {
-                    list.push_back(units);
-                    units = head.getValue();
-                }
-            }
-            else if (((type == CborBase::TypeBytes) || (type == CborBase::TypeString))
-                    && (simple == CborBase::TypeIndefinite))
-            {
-                list.push_back(units);
-                units = maxOf(units);
-            }
+    findPairs(single);
 
-            // increment progress based on cbor object size
-            if (((type == CborBase::TypeBytes) || (type == CborBase::TypeString))
-                    && (simple != CborBase::TypeIndefinite))
-            {
-                progress += head.getLength() + head.getValue();
-            }
-            else
-            {
-                progress += head.getLength();
-            }
+    return single.result;
+}
 
-            // finished processing all elements in the current container object
-            // step back up one level by popping remaining elements from the stack (list)
-            // do it in a while loop since we might have to step back up multiple times
-            while ((units == 0) || ((type == CborBase::TypeSpecial) && (simple == CborBase::TypeIndefinite)))
-            {
-                type = CborBase::TypeSpecial;
-                simple = CborBase::TypeNull;
+Cborg Cborg::find(const char* key, std::size_t keyLength) const
+{
+    // only continue if key is not NULL
+    if (key == NULL)
+    {
+        return Cborg(NULL, 0);
+    }
 
-                if (list.size() > 0)
-                {
-                    // pop from stack
-                    units = list.back();
-                    list.pop_back();
-                }
-                else
+    CborgKey match(key, keyLength);
+    CborgSingleKey single(match);
+
+    findPairs(single);
+
+    return single.result;
+}
+
+std::size_t Cborg::find(const CborgKey* keys, Cborg* values, std::size_t count) const
+{
+    // keep values of all keys, stop when every key has been found
+    class MultiKey
+    {
+    public:
+        MultiKey(const CborgKey* _keys, Cborg* _values, std::size_t _count)
+            :   keys(_keys),
+                values(_values),
+                count(_count),
+                found(0)
+        {}
+
+        bool pair(const uint8_t* pointer, const CborgHeader& head, const Cborg& value)
+        {
+            for (std::size_t idx = 0; idx < count; idx++)
+            {
+                // only the first occurrence of a key is used
+                if ((values[idx].cbor == NULL) && keys[idx].matches(pointer, head))
                 {
-                    // stack is empty, means we have reached the end of the current container
-                    return progress;
+                    values[idx] = value;
+                    found++;
                 }
             }
+
+            return (found < count);
         }
 
-        return progress;
+        const CborgKey* keys;
+        Cborg* values;
+        std::size_t count;
+        std::size_t found;
+    };
+
+    for (std::size_t idx = 0; idx < count; idx++)
+    {
+        values[idx] = Cborg(NULL, 0);
     }
-    else if ((type == CborBase::TypeBytes) || (type == CborBase::TypeString))
+
+    MultiKey multi(keys, values, count);
+
+    if (count > 0)
     {
-        // return header and length
-        return head.getLength() + head.getValue();
+        findPairs(multi);
     }
-    else
+
+    return multi.found;
+}
+
+Cborg Cborg::find(const CborgPath& path) const
+{
+    std::size_t offset = 0;
+
+    if (path.locate(cbor, maxLength, validated, &offset))
     {
-        // return header
-        return head.getLength();
+        return Cborg(&cbor[offset], maxLength - offset, validated);
     }
+
+    return Cborg(NULL, 0);
 }
 
-Cborg Cborg::find(int32_t key) const
+Cborg Cborg::at(std::size_t index) const
 {
     CborgHeader head;
-    head.decode(cbor);
+    head.decode(cbor, maxLength);
 
-    uint8_t type = head.getMajorType();
-    uint8_t simple = head.getMinorType();
+    bool indefinite = (head.getMinorType() == CborBase::TypeIndefinite);
 
-    uint32_t units = 2 * head.getValue();
-    units = (simple == CborBase::TypeIndefinite) ? maxOf(units) : units;
-
-    // only continue if type is Cbor Map and the map is not empty
-    if ((type != CborBase::TypeMap) || (units == 0))
+    // only continue if container is Cbor Array and index is within bounds
+    if ((head.getMajorType() != CborBase::TypeArray)
+        || ((!indefinite) && (index >= head.getValue())))
     {
         return Cborg(NULL, 0);
     }
 
-    // got map, look for key
-    std::list<uint32_t> list;
-    bool gotKey = false;
-
-    // skip map header
+    // skip array header and all elements before index
     std::size_t progress = head.getLength();
 
-    // iterate through cbor encoded buffer
-    // stop when maximum length is reached or
-    // the current map is finished
-    while (progress < maxLength)
+    for (std::size_t currentIndex = 0; currentIndex <= index; currentIndex++)
     {
-        // decrement unit count unless set to indefinite
-        if (units != maxOf(units))
+        // stop when maximum length is reached or the indefinite array is finished
+        if ((progress >= maxLength) || (indefinite && (cbor[progress] == breakByte)))
         {
-            units--;
+            break;
         }
 
-        // decode header for cbor object currently pointed to
-        head.decode(&cbor[progress]);
+        if (currentIndex == index)
+        {
+            return Cborg(&cbor[progress], maxLength - progress, validated);
+        }
 
-        type = head.getMajorType();
-        simple = head.getMinorType();
+        std::size_t length = 0;
 
-        // if object is a container type (map or array), push remaining units onto the stack (list)
-        // and set units to the number of elements in the new container.
-        if (type == CborBase::TypeMap)
+        if (!skipItem(&cbor[progress], maxLength - progress, validated, &length))
         {
-            gotKey = false;
-
-            if (simple == CborBase::TypeIndefinite)
-            {
-                list.push_back(units);
-                units = maxOf(units);
-            }
-            else if (head.getValue() > 0)
-            {
-                list.push_back(units);
-                units = 2 * head.getValue();
-            }
+            break;
         }
-        else if (type == CborBase::TypeArray)
-        {
-            gotKey = false;
 
-            if (simple == CborBase::TypeIndefinite)
-            {
-                list.push_back(units);
-                units = maxOf(units);
-            }
-            else if (head.getValue() > 0)
-            {
-                list.push_back(units);
-                units = head.getValue();
-            }
-        }
-        else if (((type == CborBase::TypeBytes) || (type == CborBase::TypeString))
-                && (simple == CborBase::TypeIndefinite))
-        {
-            gotKey = false;
+        progress += length;
+    }
 
-            list.push_back(units);
-            units = maxOf(units);
-        }
-        else
-        {
-            // object is not a container type
-            // if object is on the same level as the top level map then process content
-            // otherwise igonre and move on
-            if (list.size() == 0)
-            {
-                // if previous object was a key, this is a value. Skip it.
-                if (gotKey)
-                {
-                    gotKey = false;
-                }
-                else
-                {
-                    // assume keys are cbor integers.
-                    bool found = false;
+    // index not found, return null object
+    return Cborg(NULL, 0);
+}
 
-                    if (type == CborBase::TypeUnsigned)
-                    {
-                        if ((int32_t) head.getValue() == key)
-                        {
-                            found = true;
-                        }
-                    }
-                    else if (type == CborBase::TypeNegative)
-                    {
-                        if ((-1 - (int32_t) head.getValue()) == key)
-                        {
-                            found = true;
-                        }
-                    }
+CborgRange<CborgIterator> Cborg::elements() const
+{
+    if (getType() == CborBase::TypeArray)
+    {
+        return CborgRange<CborgIterator>(CborgIterator(cbor, maxLength, false, validated));
+    }
 
-                    if (found)
-                    {
-                        // update progress to point to next object
-                        progress += head.getLength();
+    return CborgRange<CborgIterator>(CborgIterator());
+}
 
-                        // return new Cborg object based on object pointer and max length
-                        return Cborg(&cbor[progress], maxLength - progress);
-                    }
+CborgRange<CborgPairIterator> Cborg::pairs() const
+{
+    if (getType() == CborBase::TypeMap)
+    {
+        return CborgRange<CborgPairIterator>(CborgPairIterator(cbor, maxLength, validated));
+    }
 
-                    // this object is a key, but the key didn't match
-                    // signal that the next object is a value
-                    gotKey = true;
-                }
-            }
-        }
+    return CborgRange<CborgPairIterator>(CborgPairIterator());
+}
 
-        // increment progress based on cbor object size
-        if (((type == CborBase::TypeBytes) || (type == CborBase::TypeString))
-                && (simple != CborBase::TypeIndefinite))
+uint32_t Cborg::getSize() const
+{
+    CborgHeader head;
+    head.decode(cbor, maxLength);
+
+    uint8_t type = head.getMajorType();
+    uint8_t simple = head.getMinorType();
+
+    if ((type == CborBase::TypeMap)
+        || (type == CborBase::TypeArray)
+        || (type == CborBase::TypeString)
+        || (type == CborBase::TypeBytes))
+    {
+        if (simple == CborBase::TypeIndefinite)
         {
-            progress += head.getLength() + head.getValue();
+            return std::numeric_limits<uint32_t>::max();
         }
-        else
+        else if (head.getValue() < std::numeric_limits<uint32_t>::max())
         {
-            progress += head.getLength();
+            return head.getValue();
         }
-
-        // finished processing all elements in the current container object
-        // step back up one level by popping remaining elements from the stack (list)
-        // do it in a while loop since we might have to step back up multiple times
-        while ((units == 0) || ((type == CborBase::TypeSpecial) && (simple == CborBase::TypeIndefinite)))
+        else
         {
-            type = CborBase::TypeSpecial;
-            simple = CborBase::TypeNull;
-
-            if (list.size() > 0)
-            {
-                // pop from stack
-                units = list.back();
-                list.pop_back();
-            }
-            else
-            {
-                // stack is empty, means we have reached the end of the current container
-                // return a Cbor null object
-                return Cborg(NULL, 0);
-            }
+            // use getBytes() or getString() for payloads beyond 32 bits
+            return std::numeric_limits<uint32_t>::max();
         }
     }
-
-    // key not found, retun null object
-    return Cborg(NULL, 0);
+    else
+    {
+        return 0;
+    }
 }
 
-Cborg Cborg::find(const char* key, std::size_t keyLength) const
-{
-    CborgHeader head;
-    head.decode(cbor);
 
-    uint8_t type = head.getMajorType();
-    uint8_t simple = head.getMinorType();
+bool Cborg::getUnsigned(uint32_t* integer) const
+{
+    uint64_t value;
 
-    uint32_t units = 2 * head.getValue();
-    units = (simple == CborBase::TypeIndefinite) ? maxOf(units) : units;
+    if (getUnsigned(&value) && (value <= std::numeric_limits<uint32_t>::max()))
+    {
+        *integer = value;
 
-    // only continue if type is Cbor Map, key is not NULL, and the map is not empty
-    if ((type != CborBase::TypeMap) || (key == NULL) || (units == 0))
+        return true;
+    }
+    else
     {
-        return Cborg(NULL, 0);
+        return false;
     }
+}
 
-    // got map, look for key
-    std::list<uint32_t> list;
-    bool gotKey = false;
-
-    // skip map header
-    std::size_t progress = head.getLength();
+bool Cborg::getUnsigned(uint64_t* integer) const
+{
+    CborgHeader head;
+    head.decode(cbor, maxLength);
 
-    // iterate through cbor encoded buffer
-    // stop when maximum length is reached or
-    // the current map is finished
-    while (progress < maxLength)
+    if (head.getMajorType() == CborBase::TypeUnsigned)
     {
-        // decrement unit count unless set to indefinite
-        if (units != maxOf(units))
-        {
-            units--;
-        }
-
-        // decode header for cbor object currently pointed to
-        head.decode(&cbor[progress]);
+        *integer = head.getValue();
 
-        type = head.getMajorType();
-        simple = head.getMinorType();
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
 
-        // if object is a container type (map or array), push remaining units onto the stack (list)
-        // and set units to the number of elements in the new container.
-        if (type == CborBase::TypeMap)
-        {
-            gotKey = false;
+bool Cborg::getNegative(int32_t* integer) const
+{
+    int64_t value;
 
-            if (simple == CborBase::TypeIndefinite)
-            {
-                list.push_back(units);
-                units = maxOf(units);
-            }
-            else if (head.getValue() > 0)
-            {
-                list.push_back(units);
-                units = 2 * head.getValue();
-            }
-        }
-        else if (type == CborBase::TypeArray)
-        {
-            gotKey = false;
+    if (getNegative(&value) && (value >= std::numeric_limits<int32_t>::min()))
+    {
+        *integer = value;
 
-            if (simple == CborBase::TypeIndefinite)
-            {
-                list.push_back(units);
-                units = maxOf(units);
-            }
-            else if (head.getValue() > 0)
-            {
-                list.push_back(units);
-                units = head.getValue();
-            }
-        }
-        else if (((type == CborBase::TypeBytes) || (type == CborBase::TypeString))
-                && (simple == CborBase::TypeIndefinite))
-        {
-            gotKey = false;
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
 
-            list.push_back(units);
-            units = maxOf(units);
-        }
-        else
-        {
-            // object is not a container type
-            // if object is on the same level as the top level map then process content
-            // otherwise igonre and move on
-            if (list.size() == 0)
-            {
-                // if previous object was a key, this is a value. Skip it.
-                if (gotKey)
-                {
-                    gotKey = false;
-                }
-                else
-                {
-                    // if object is a string and the length matches the key length
-                    // do a byte-by-byte comparison
-                    if (type == CborBase::TypeString)
-                    {
-                        if (head.getValue() == keyLength)
-                        {
-                            bool found = true;
-
-                            for (std::size_t idx = 0; idx < keyLength; idx++)
-                            {
-                                // break out of loop if string is different from the key
-                                if (key[idx] != cbor[progress + head.getLength() + idx])
-                                {
-                                    found = false;
-                                    break;
-                                }
-                            }
-
-                            if (found)
-                            {
-                                // update progress to point to next object
-                                progress += head.getLength() + head.getValue();
-
-                                // return new Cborg object based on object pointer and max length
-                                return Cborg(&cbor[progress], maxLength - progress);
-                            }
-                        }
-                    }
+bool Cborg::getNegative(int64_t* integer) const
+{
+    CborgHeader head;
+    head.decode(cbor, maxLength);
 
-                    // this object is a key, but the key didn't match
-                    // signal that the next object is a value
-                    gotKey = true;
-                }
-            }
-        }
+    // -1 - value must not go below INT64_MIN
+    if ((head.getMajorType() == CborBase::TypeNegative) && (head.getValue() <= (uint64_t) std::numeric_limits<int64_t>::max()))
+    {
+        *integer = -1 - (int64_t) head.getValue();
 
-        // increment progress based on cbor object size
-        if (((type == CborBase::TypeBytes) || (type == CborBase::TypeString))
-                && (simple != CborBase::TypeIndefinite))
-        {
-            progress += head.getLength() + head.getValue();
-        }
-        else
-        {
-            progress += head.getLength();
-        }
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
 
-        // finished processing all elements in the current container object
-        // step back up one level by popping remaining elements from the stack (list)
-        // do it in a while loop since we might have to step back up multiple times
-        while ((units == 0) || ((type == CborBase::TypeSpecial) && (simple == CborBase::TypeIndefinite)))
+bool Cborg::getInteger(int64_t* integer) const
+{
+    uint64_t value;
+
+    if (getUnsigned(&value))
+    {
+        if (value <= (uint64_t) std::numeric_limits<int64_t>::max())
         {
-            type = CborBase::TypeSpecial;
-            simple = CborBase::TypeNull;
+            *integer = value;
 
-            if (list.size() > 0)
-            {
-                // pop from stack
-                units = list.back();
-                list.pop_back();
-            }
-            else
-            {
-                // stack is empty, means we have reached the end of the current container
-                // return a Cbor null object
-                return Cborg(NULL, 0);
-            }
+            return true;
         }
+
+        return false;
     }
 
-    // key not found, retun null object
-    return Cborg(NULL, 0);
+    return getNegative(integer);
 }
 
-Cborg Cborg::at(std::size_t index) const
+bool Cborg::getFloat(float* value) const
 {
     CborgHeader head;
-    head.decode(cbor);
+    head.decode(cbor, maxLength);
 
-    uint8_t type = head.getMajorType();
-    uint8_t simple = head.getMinorType();
+    return (head.getMajorType() == CborBase::TypeSpecial)
+        && CborgFloat::narrow(head.getMinorType(), head.getValue(), value);
+}
+
+bool Cborg::getDouble(double* value) const
+{
+    CborgHeader head;
+    head.decode(cbor, maxLength);
+
+    return (head.getMajorType() == CborBase::TypeSpecial)
+        && CborgFloat::widen(head.getMinorType(), head.getValue(), value);
+}
 
-    // set units to elements in array
-    int32_t units = head.getValue();
-    units = (simple == CborBase::TypeIndefinite) ? maxOf(units) : units;
+std::size_t Cborg::getFloats(float* values, std::size_t count) const
+{
+    CborgHeader head;
+    head.decode(cbor, maxLength);
 
-    // only continue if container is Cbor Map, not empty, and index is within bounds
-    if ((type != CborBase::TypeArray) || (units == 0) || ((int32_t) index >= units))
+    if (head.getMajorType() != CborBase::TypeArray)
     {
-        return Cborg(NULL, 0);
+        return 0;
     }
 
-    // got array, look for index
-    std::list<uint32_t> list;
-    std::size_t currentIndex = 0;
+    bool indefinite = (head.getMinorType() == CborBase::TypeIndefinite);
+
+    if ((!indefinite) && (head.getValue() < count))
+    {
+        count = (std::size_t) head.getValue();
+    }
 
-    // skip array header
     std::size_t progress = head.getLength();
+    std::size_t read = 0;
 
-    // iterate through cbor encoded buffer
-    // stop when maximum length is reached or
-    // the current array is finished
-    while (progress < maxLength)
+    // runs of half precision values are collected and converted in blocks
+    const std::size_t block = 32;
+    uint16_t halves[block];
+
+    while ((read < count) && (progress < maxLength))
     {
-        // compare current array index with the one sought for and return if found
-        if (currentIndex == index)
+        std::size_t run = 0;
+
+        while ((run < block) && (read + run < count) && (progress + 3 <= maxLength)
+               && (cbor[progress] == halfByte))
         {
-            return Cborg(&cbor[progress], maxLength - progress);
+            halves[run++] = ((uint16_t) cbor[progress + 1] << 8) | cbor[progress + 2];
+            progress += 3;
         }
-        else
-        {
-            // decrement unit count unless set to indefinite
-            if (units != maxOf(units))
-            {
-                units--;
-            }
-
-            // decode header for cbor object currently pointed to
-            head.decode(&cbor[progress]);
-
-            type = head.getMajorType();
-            simple = head.getMinorType();
-
-            // if object is a container type (map or array), push remaining units onto the stack (list)
-            // and set units to the number of elements in the new container.
-            if (type == CborBase::TypeMap)
-            {
-                if (simple == CborBase::TypeIndefinite)
-                {
-                    list.push_back(units);
-                    units = maxOf(units);
-                }
-                else if (head.getValue() > 0)
-                {
-                    list.push_back(units);
-                    units = 2 * head.getValue();
-                }
-            }
-            else if (type == CborBase::TypeArray)
-            {
-                if (simple == CborBase::TypeIndefinite)
-                {
-                    list.push_back(units);
-                    units = maxOf(units);
-                }
-                else if (head.getValue() > 0)
-                {
-                    list.push_back(units);
-                    units = head.getValue();
-                }
-            }
-            else if (((type == CborBase::TypeBytes) || (type == CborBase::TypeString))
-                    && (simple == CborBase::TypeIndefinite))
-            {
-                list.push_back(units);
-                units = maxOf(units);
-            }
 
-            // increment progress based on cbor object size
-            if (((type == CborBase::TypeBytes) || (type == CborBase::TypeString))
-                    && (simple != CborBase::TypeIndefinite))
-            {
-                progress += head.getLength() + head.getValue();
-            }
-            else
-            {
-                progress += head.getLength();
-            }
+        if (run > 0)
+        {
+            CborgFloat::halfToFloat(halves, &values[read], run);
+            read += run;
 
-            // finished processing all elements in the current container object
-            // step back up one level by popping remaining elements from the stack (list)
-            // do it in a while loop since we might have to step back up multiple times
-            while ((units == 0) || ((type == CborBase::TypeSpecial) && (simple == CborBase::TypeIndefinite)))
-            {
-                type = CborBase::TypeSpecial;
-                simple = CborBase::TypeNull;
+            continue;
+        }
 
-                if (list.size() > 0)
-                {
-                    // pop from stack
-                    units = list.back();
-                    list.pop_back();
-                }
-                else
-                {
-                    // stack is empty, means we have reached the end of the current container
-                    // return a Cbor null object
-                    return Cborg(NULL, 0);
-                }
-            }
+        // the header must be within bounds before it is decoded
+        if (!head.decode(&cbor[progress], maxLength - progress))
+        {
+            break;
+        }
 
-            // if element is on the top level, increment index counter
-            if (list.size() == 0)
-            {
-                currentIndex++;
-            }
+        if ((head.getTag() != CborBase::TypeUnassigned)
+            || (head.getMajorType() != CborBase::TypeSpecial)
+            || !CborgFloat::narrow(head.getMinorType(), head.getValue(), &values[read]))
+        {
+            break;
         }
+
+        progress += head.getLength();
+        read++;
     }
 
-    // index not found, return null object
-    return Cborg(NULL, 0);
+    return read;
 }
 
-uint32_t Cborg::getSize() const
+const void* Cborg::typedArray(uint32_t tag, std::size_t width, void* buffer, std::size_t capacity,
+                              std::size_t* count, bool* copied) const
 {
     CborgHeader head;
-    head.decode(cbor);
+    head.decode(cbor, maxLength);
+
+    // same element type in either byte order
+    bool native = (head.getTag() == tag);
+    bool swapped = (head.getTag() == (tag ^ CborgTyped::TagLittleEndian));
+
+    if ((!native && !swapped)
+        || (head.getMajorType() != CborBase::TypeBytes)
+        || (head.getMinorType() == CborBase::TypeIndefinite)
+        || (head.getLength() > maxLength)
+        || (head.getValue() > maxLength - head.getLength())
+        || (head.getValue() % width != 0))
+    {
+        return NULL;
+    }
 
-    uint8_t type = head.getMajorType();
-    uint8_t simple = head.getMinorType();
+    const uint8_t* payload = &cbor[head.getLength()];
+    *count = (std::size_t) head.getValue() / width;
 
-    if ((type == CborBase::TypeMap)
-        || (type == CborBase::TypeArray)
-        || (type == CborBase::TypeString)
-        || (type == CborBase::TypeBytes))
+    // single byte elements have no byte order
+    if (width == 1)
     {
-        if (simple == CborBase::TypeIndefinite)
-        {
-            return std::numeric_limits<uint32_t>::max();
-        }
-        else
-        {
-            return head.getValue();
-        }
+        swapped = false;
+    }
+
+    if ((!swapped) && ((uintptr_t) payload % width == 0))
+    {
+        *copied = false;
+
+        return payload;
+    }
+
+    if ((buffer == NULL) || (capacity < *count))
+    {
+        return NULL;
+    }
+
+    if (swapped)
+    {
+        CborgTyped::swap(payload, (uint8_t*) buffer, *count, width);
     }
     else
     {
-        return 0;
+        memcpy(buffer, payload, *count * width);
     }
-}
 
+    *copied = true;
 
-bool Cborg::getUnsigned(uint32_t* integer) const
+    return buffer;
+}
+
+bool Cborg::getBytes(const uint8_t** pointer, uint32_t* length) const
 {
-    CborgHeader head;
-    head.decode(cbor);
+    uint64_t value;
 
-    if (head.getMajorType() == CborBase::TypeUnsigned)
+    if (getBytes(pointer, &value) && (value <= std::numeric_limits<uint32_t>::max()))
     {
-        *integer = head.getValue();
+        *length = value;
 
         return true;
     }
@@ -827,14 +807,19 @@ bool Cborg::getUnsigned(uint32_t* integer) const
     }
 }
 
-bool Cborg::getNegative(int32_t* integer) const
+bool Cborg::getBytes(const uint8_t** pointer, uint64_t* length) const
 {
     CborgHeader head;
-    head.decode(cbor);
+    head.decode(cbor, maxLength);
 
-    if (head.getMajorType() == CborBase::TypeNegative)
+    // definite length bytes that fit in the buffer
+    if ((head.getMajorType() == CborBase::TypeBytes)
+        && (head.getMinorType() != CborBase::TypeIndefinite)
+        && (head.getLength() <= maxLength)
+        && (head.getValue() <= maxLength - head.getLength()))
     {
-        *integer = -1 - head.getValue();
+        *pointer = &cbor[head.getLength()];
+        *length = head.getValue();
 
         return true;
     }
@@ -844,15 +829,13 @@ bool Cborg::getNegative(int32_t* integer) const
     }
 }
 
-bool Cborg::getBytes(const uint8_t** pointer, uint32_t* length) const
+bool Cborg::getString(const char** pointer, uint32_t* length) const
 {
-    CborgHeader head;
-    head.decode(cbor);
+    uint64_t value;
 
-    if (head.getMajorType() == CborBase::TypeBytes)
+    if (getString(pointer, &value) && (value <= std::numeric_limits<uint32_t>::max()))
     {
-        *pointer = &cbor[head.getLength()];
-        *length = head.getValue();
+        *length = value;
 
         return true;
     }
@@ -862,12 +845,16 @@ bool Cborg::getBytes(const uint8_t** pointer, uint32_t* length) const
     }
 }
 
-bool Cborg::getString(const char** pointer, uint32_t* length) const
+bool Cborg::getString(const char** pointer, uint64_t* length) const
 {
     CborgHeader head;
-    head.decode(cbor);
+    head.decode(cbor, maxLength);
 
-    if (head.getMajorType() == CborBase::TypeString)
+    // definite length strings that fit in the buffer
+    if ((head.getMajorType() == CborBase::TypeString)
+        && (head.getMinorType() != CborBase::TypeIndefinite)
+        && (head.getLength() <= maxLength)
+        && (head.getValue() <= maxLength - head.getLength()))
     {
         *pointer = (const char*) &cbor[head.getLength()];
         *length = head.getValue();
@@ -882,12 +869,13 @@ bool Cborg::getString(const char** pointer, uint32_t* length) const
 
 bool Cborg::getString(std::string& str) const
 {
-    CborgHeader head;
-    head.decode(cbor);
+    const char* pointer;
+    uint64_t length;
 
-    if (head.getMajorType() == CborBase::TypeString)
+    // bounded by maxLength, so the length fits in size_t
+    if (getString(&pointer, &length))
     {
-        str.assign((const char*) &cbor[head.getLength()], head.getValue());
+        str.assign(pointer, (std::size_t) length);
 
         return true;
     }
@@ -904,7 +892,7 @@ bool Cborg::getString(std::string& str) const
 uint32_t Cborg::getTag() const
 {
     CborgHeader head;
-    head.decode(cbor);
+    head.decode(cbor, maxLength);
 
     return head.getTag();
 }
@@ -912,7 +900,7 @@ uint32_t Cborg::getTag() const
 uint8_t Cborg::getType() const
 {
     CborgHeader head;
-    head.decode(cbor);
+    head.decode(cbor, maxLength);
 
     return head.getMajorType();
 }
@@ -920,247 +908,168 @@ uint8_t Cborg::getType() const
 uint8_t Cborg::getMinorType() const
 {
     CborgHeader head;
-    head.decode(cbor);
+    head.decode(cbor, maxLength);
 
     return head.getMinorType();
 }
 
-
 /*****************************************************************************/
-/* Debug related                                                             */
+/* Iterators                                                                 */
 /*****************************************************************************/
 
-void Cborg::print() const
+CborgIterator::CborgIterator()
+    :   cbor(NULL),
+        maxLength(0),
+        progress(0),
+        keyLength(0),
+        units(0),
+        indefinite(false),
+        pairs(false),
+        validated(false),
+        done(true)
+{}
+
+CborgIterator::CborgIterator(const uint8_t* _cbor, std::size_t _maxLength, bool _pairs, bool _validated)
+    :   cbor(_cbor),
+        maxLength(_maxLength),
+        progress(0),
+        keyLength(0),
+        units(0),
+        indefinite(false),
+        pairs(_pairs),
+        validated(_validated),
+        done(false)
 {
     CborgHeader head;
-    std::size_t progress = 0;
+    head.decode(cbor, maxLength);
 
-    std::list<uint32_t> list;
-    uint32_t units = 1;
-
-    while (progress < maxLength)
-    {
-        // decrement unit count unless set to indefinite
-        if (units != maxOf(units))
-        {
-            units--;
-        }
+    indefinite = (head.getMinorType() == CborBase::TypeIndefinite);
+    units = (std::size_t) head.getValue();
 
-        head.decode(&cbor[progress]);
+    // skip container header
+    progress = head.getLength();
 
-        /* semantic tag */
-        uint32_t tag = head.getTag();
-        uint8_t type = head.getMajorType();
-        uint8_t simple = head.getMinorType();
+    settle();
+}
 
-        if ((type != CborBase::TypeSpecial) || (simple != CborBase::TypeIndefinite))
-        {
-            for (std::size_t indent = 0; indent < list.size(); indent++)
-            {
-                printf("\t");
-            }
-        }
+/*
+    Check whether the container is finished and, for maps, find the
+    value belonging to the current key.
+*/
+void CborgIterator::settle()
+{
+    if ((cbor == NULL)
+        || ((!indefinite) && (units == 0))
+        || (progress >= maxLength)
+        || (indefinite && (cbor[progress] == breakByte)))
+    {
+        done = true;
+        return;
+    }
 
-        if (tag != CborBase::TypeUnassigned)
+    if (pairs)
+    {
+        if ((!skipItem(&cbor[progress], maxLength - progress, validated, &keyLength))
+            || (progress + keyLength >= maxLength))
         {
-            printf("[%" PRIu32 "] ", tag);
+            done = true;
         }
+    }
+}
 
-        /* container object */
-        if (type == CborBase::TypeMap)
-        {
-            if (simple == CborBase::TypeIndefinite)
-            {
-                printf("Map:\r\n");
+Cborg CborgIterator::operator*() const
+{
+    if (done)
+    {
+        return Cborg(NULL, 0);
+    }
 
-                list.push_back(units);
-                units = maxOf(units);
-            }
-            else if (head.getValue() > 0)
-            {
-                printf("Map: %" PRIu32 "\r\n", head.getValue());
+    std::size_t position = progress + keyLength;
 
-                list.push_back(units);
-                units = 2 * head.getValue();
-            }
-        }
-        else if (type == CborBase::TypeArray)
-        {
-            if (simple == CborBase::TypeIndefinite)
-            {
-                printf("Array:\r\n");
+    return Cborg(&cbor[position], maxLength - position, validated);
+}
 
-                list.push_back(units);
-                units = maxOf(units);
-            }
-            else if (head.getValue() > 0)
-            {
-                printf("Array: %" PRIu32 "\r\n", head.getValue());
+CborgIterator& CborgIterator::operator++()
+{
+    if (!done)
+    {
+        // skip value or element
+        std::size_t position = progress + keyLength;
+        std::size_t length = 0;
 
-                list.push_back(units);
-                units = head.getValue();
-            }
-        }
-        else if ((type == CborBase::TypeBytes) && (simple == CborBase::TypeIndefinite))
+        if (!skipItem(&cbor[position], maxLength - position, validated, &length))
         {
-            printf("Bytes:\r\n");
-
-            list.push_back(units);
-            units = maxOf(units);
+            done = true;
         }
-        else if ((type == CborBase::TypeString) && (simple == CborBase::TypeIndefinite))
+        else
         {
-            printf("String:\r\n");
+            progress = position + length;
+            keyLength = 0;
+            units--;
 
-            list.push_back(units);
-            units = maxOf(units);
+            settle();
         }
-        else
-        {
-            switch(type)
-            {
-                case CborBase::TypeUnsigned:
-                    {
-                        Cborg object(&cbor[progress], maxLength - progress);
-                        uint32_t integer = 0;
-                        bool result = object.getUnsigned(&integer);
+    }
 
-                        if (result)
-                        {
-                            printf("%" PRIu32 "\r\n", integer);
-                        }
-                        else
-                        {
-                            printf("\r\n");
-                        }
-                    }
-                    break;
+    return *this;
+}
 
-                case CborBase::TypeNegative:
-                    {
-                        Cborg object(&cbor[progress], maxLength - progress);
-                        int32_t integer = 0;
-                        bool result = object.getNegative(&integer);
+bool CborgIterator::operator==(const CborgIterator& other) const
+{
+    if (done || other.done)
+    {
+        return (done == other.done);
+    }
 
-                        if (result)
-                        {
-                            printf("%" PRId32 "\r\n", integer);
-                        }
-                        else
-                        {
-                            printf("\r\n");
-                        }
-                    }
-                    break;
+    return (cbor == other.cbor) && (progress == other.progress);
+}
 
-                case CborBase::TypeBytes:
-                    {
-                        Cborg object(&cbor[progress], maxLength - progress);
-                        const uint8_t* pointer;
-                        uint32_t length;
+bool CborgIterator::operator!=(const CborgIterator& other) const
+{
+    return !(*this == other);
+}
 
-                        bool result = object.getBytes(&pointer, &length);
+CborgPairIterator::CborgPairIterator()
+    :   CborgIterator()
+{}
 
-                        if (result)
-                        {
-                            for (std::size_t idx = 0; idx < length; idx++)
-                            {
-                                printf("%02X", pointer[idx]);
-                            }
-                        }
-                        printf("\r\n");
-                    }
-                    break;
+CborgPairIterator::CborgPairIterator(const uint8_t* _cbor, std::size_t _maxLength, bool _validated)
+    :   CborgIterator(_cbor, _maxLength, true, _validated)
+{}
 
-                case CborBase::TypeString:
-                    {
-                        Cborg object(&cbor[progress], maxLength - progress);
-                        const char* pointer;
-                        uint32_t length;
+CborgPair CborgPairIterator::operator*() const
+{
+    CborgPair pair;
 
-                        bool result = object.getString(&pointer, &length);
+    if (!done)
+    {
+        pair.key = Cborg(&cbor[progress], keyLength, validated);
+        pair.value = CborgIterator::operator*();
+    }
 
-                        if (result)
-                        {
-                            for (std::size_t idx = 0; idx < length; idx++)
-                            {
-                                printf("%c", pointer[idx]);
-                            }
-                        }
-                        printf("\r\n");
-                    }
-                    break;
+    return pair;
+}
 
-                case CborBase::TypeSpecial:
-                    {
-                        if (simple == CborBase::TypeTrue)
-                        {
-                            printf("true\r\n");
-                        }
-                        else if (simple == CborBase::TypeFalse)
-                        {
-                            printf("false\r\n");
-                        }
-                        else if (simple == CborBase::TypeNull)
-                        {
-                            printf("null\r\n");
-                        }
-                        else if (simple == CborBase::TypeUndefined)
-                        {
-                            printf("undefined\r\n");
-                        }
-                        else if (simple == CborBase::TypeHalfFloat)
-                        {
-                            printf("half float\r\n");
-                        }
-                        else if (simple == CborBase::TypeSingleFloat)
-                        {
-                            printf("single float\r\n");
-                        }
-                        else if (simple == CborBase::TypeDoubleFloat)
-                        {
-                            printf("double float\r\n");
-                        }
-                    }
-                    break;
+CborgPairIterator& CborgPairIterator::operator++()
+{
+    CborgIterator::operator++();
 
-                default:
-                    printf("error\r\n");
-                    return;
-                    break;
-            }
-        }
+    return *this;
+}
 
-        // increment progress based on cbor object size
-        if (((type == CborBase::TypeBytes) || (type == CborBase::TypeString))
-                && (simple != CborBase::TypeIndefinite))
-        {
-            progress += head.getLength() + head.getValue();
-        }
-        else
-        {
-            progress += head.getLength();
-        }
+/*****************************************************************************/
+/* Debug related                                                             */
+/*****************************************************************************/
 
-        // finished processing all elements in the current container object
-        // step back up one level by popping remaining elements from the stack (list)
-        // do it in a while loop since we might have to step back up multiple times
-        while ((units == 0) || ((type == CborBase::TypeSpecial) && (simple == CborBase::TypeIndefinite)))
-        {
-            type = CborBase::TypeSpecial;
-            simple = CborBase::TypeNull;
+void Cborg::print() const
+{
+    CborgPrinter printer;
+    std::size_t length = 0;
 
-            if (list.size() > 0)
-            {
-                units = list.back();
-                list.pop_back();
-            }
-            else
-            {
-                return;
-            }
-        }
+    CborgTraverse::Status_t status = CborgTraverse::visit(cbor, maxLength, printer, &length);
+
+    if ((status == CborgTraverse::StatusDepthExceeded) || (status == CborgTraverse::StatusMalformed))
+    {
+        printf("error\r\n");
     }
 }
-
-
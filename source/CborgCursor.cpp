@@ -0,0 +1,499 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cborg/CborgCursor.h"
+#include "cborg/CborgFloat.h"
+
+#include <limits>
+
+namespace {
+    // unit count of indefinite containers
+    const std::size_t indefinite = (std::size_t) -1;
+}
+
+CborgCursor::CborgCursor(const uint8_t* _cbor, std::size_t _maxLength)
+    :   cbor(_cbor),
+        maxLength(_maxLength),
+        progress(0),
+        status(CborgTraverse::StatusOk),
+        end(false)
+{
+    // the document itself is a single item
+    frames.push_back(1);
+
+    if (cbor == NULL)
+    {
+        fail(CborgTraverse::StatusTruncated);
+    }
+    else
+    {
+        settle();
+    }
+}
+
+/*****************************************************************************/
+/* Movement                                                                  */
+/*****************************************************************************/
+
+bool CborgCursor::next()
+{
+    if (status != CborgTraverse::StatusOk)
+    {
+        return false;
+    }
+
+    if (end)
+    {
+        return leave();
+    }
+
+    if (isContainer())
+    {
+        return push();
+    }
+
+    return skip();
+}
+
+bool CborgCursor::skip()
+{
+    if ((status != CborgTraverse::StatusOk) || end)
+    {
+        return false;
+    }
+
+    std::size_t length = 0;
+    CborgTraverse::Status_t result = CborgTraverse::skip(&cbor[progress], maxLength - progress, &length);
+
+    if (result != CborgTraverse::StatusOk)
+    {
+        return fail(result);
+    }
+
+    progress += length;
+
+    if (frames.back() != indefinite)
+    {
+        frames.back()--;
+    }
+
+    settle();
+
+    return (status == CborgTraverse::StatusOk);
+}
+
+bool CborgCursor::enter()
+{
+    if ((status != CborgTraverse::StatusOk) || end || !isContainer())
+    {
+        return false;
+    }
+
+    return push();
+}
+
+bool CborgCursor::leave()
+{
+    // the document level can not be left
+    if ((status != CborgTraverse::StatusOk) || (frames.size() <= 1))
+    {
+        return false;
+    }
+
+    // skip remaining items
+    while (!end)
+    {
+        if (!skip())
+        {
+            return false;
+        }
+    }
+
+    // step over break marker
+    if (frames.back() == indefinite)
+    {
+        progress += head.getLength();
+    }
+
+    frames.pop_back();
+
+    settle();
+
+    return (status == CborgTraverse::StatusOk);
+}
+
+/*
+    Step into the container at the current position.
+*/
+bool CborgCursor::push()
+{
+    if (frames.back() != indefinite)
+    {
+        frames.back()--;
+    }
+
+    std::size_t units = indefinite;
+
+    if (head.getMinorType() != CborBase::TypeIndefinite)
+    {
+        std::size_t width = (head.getMajorType() == CborBase::TypeMap) ? 2 : 1;
+
+        // every element takes at least one byte
+        if (head.getValue() > maxLength / width)
+        {
+            return fail(CborgTraverse::StatusTruncated);
+        }
+
+        units = width * (std::size_t) head.getValue();
+    }
+
+    if (!frames.push_back(units))
+    {
+        return fail(CborgTraverse::StatusDepthExceeded);
+    }
+
+    progress += head.getLength();
+
+    settle();
+
+    return (status == CborgTraverse::StatusOk);
+}
+
+/*
+    Decode the item at the current position or detect the end of the
+    current container.
+*/
+void CborgCursor::settle()
+{
+    std::size_t units = frames.back();
+
+    if (units == 0)
+    {
+        end = true;
+        return;
+    }
+
+    // the complete header, including a tag, must be within bounds
+    if ((progress >= maxLength) || !head.decode(&cbor[progress], maxLength - progress))
+    {
+        fail(CborgTraverse::StatusTruncated);
+        return;
+    }
+
+    uint8_t type = head.getMajorType();
+
+    if ((type == CborBase::TypeSpecial) && (head.getMinorType() == CborBase::TypeIndefinite))
+    {
+        // break is only valid as the end of an indefinite container
+        if (units != indefinite)
+        {
+            fail(CborgTraverse::StatusMalformed);
+            return;
+        }
+
+        end = true;
+    }
+    else if (type == CborBase::TypeUnassigned)
+    {
+        // reserved minor type
+        fail(CborgTraverse::StatusMalformed);
+    }
+    else
+    {
+        end = false;
+    }
+}
+
+bool CborgCursor::fail(CborgTraverse::Status_t _status)
+{
+    status = _status;
+    end = true;
+
+    return false;
+}
+
+bool CborgCursor::isContainer() const
+{
+    uint8_t type = head.getMajorType();
+
+    return (type == CborBase::TypeMap)
+        || (type == CborBase::TypeArray)
+        || (((type == CborBase::TypeBytes) || (type == CborBase::TypeString))
+            && (head.getMinorType() == CborBase::TypeIndefinite));
+}
+
+/*****************************************************************************/
+/* Position                                                                  */
+/*****************************************************************************/
+
+bool CborgCursor::isEnd() const
+{
+    return end;
+}
+
+std::size_t CborgCursor::getDepth() const
+{
+    return frames.size() - 1;
+}
+
+std::size_t CborgCursor::getOffset() const
+{
+    return progress;
+}
+
+CborgTraverse::Status_t CborgCursor::getStatus() const
+{
+    return status;
+}
+
+/*****************************************************************************/
+/* Current item                                                              */
+/*****************************************************************************/
+
+uint32_t CborgCursor::getTag() const
+{
+    return (end) ? (uint32_t) CborBase::TypeUnassigned : head.getTag();
+}
+
+uint8_t CborgCursor::getType() const
+{
+    return (end) ? (uint8_t) CborBase::TypeUnassigned : head.getMajorType();
+}
+
+uint8_t CborgCursor::getMinorType() const
+{
+    return (end) ? (uint8_t) CborBase::TypeUnassigned : head.getMinorType();
+}
+
+uint32_t CborgCursor::getSize() const
+{
+    uint8_t type = getType();
+
+    if ((type == CborBase::TypeMap)
+        || (type == CborBase::TypeArray)
+        || (type == CborBase::TypeString)
+        || (type == CborBase::TypeBytes))
+    {
+        if (head.getMinorType() == CborBase::TypeIndefinite)
+        {
+            return std::numeric_limits<uint32_t>::max();
+        }
+        else if (head.getValue() < std::numeric_limits<uint32_t>::max())
+        {
+            return head.getValue();
+        }
+        else
+        {
+            // use getBytes() or getString() for payloads beyond 32 bits
+            return std::numeric_limits<uint32_t>::max();
+        }
+    }
+    else
+    {
+        return 0;
+    }
+}
+
+bool CborgCursor::getUnsigned(uint32_t* integer) const
+{
+    uint64_t value;
+
+    if (getUnsigned(&value) && (value <= std::numeric_limits<uint32_t>::max()))
+    {
+        *integer = value;
+
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+bool CborgCursor::getUnsigned(uint64_t* integer) const
+{
+    if (getType() == CborBase::TypeUnsigned)
+    {
+        *integer = head.getValue();
+
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+bool CborgCursor::getNegative(int32_t* integer) const
+{
+    int64_t value;
+
+    if (getNegative(&value) && (value >= std::numeric_limits<int32_t>::min()))
+    {
+        *integer = value;
+
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+bool CborgCursor::getNegative(int64_t* integer) const
+{
+    // -1 - value must not go below INT64_MIN
+    if ((getType() == CborBase::TypeNegative)
+        && (head.getValue() <= (uint64_t) std::numeric_limits<int64_t>::max()))
+    {
+        *integer = -1 - (int64_t) head.getValue();
+
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+bool CborgCursor::getInteger(int64_t* integer) const
+{
+    uint64_t value;
+
+    if (getUnsigned(&value))
+    {
+        if (value <= (uint64_t) std::numeric_limits<int64_t>::max())
+        {
+            *integer = value;
+
+            return true;
+        }
+
+        return false;
+    }
+
+    return getNegative(integer);
+}
+
+bool CborgCursor::getFloat(float* value) const
+{
+    return (getType() == CborBase::TypeSpecial)
+        && CborgFloat::narrow(head.getMinorType(), head.getValue(), value);
+}
+
+bool CborgCursor::getDouble(double* value) const
+{
+    return (getType() == CborBase::TypeSpecial)
+        && CborgFloat::widen(head.getMinorType(), head.getValue(), value);
+}
+
+bool CborgCursor::getBytes(const uint8_t** pointer, uint32_t* length) const
+{
+    uint64_t value;
+
+    if (getBytes(pointer, &value) && (value <= std::numeric_limits<uint32_t>::max()))
+    {
+        *length = value;
+
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+bool CborgCursor::getBytes(const uint8_t** pointer, uint64_t* length) const
+{
+    // definite length strings that fit in the buffer, compared so that
+    // 64-bit lengths can not wrap
+    if ((getType() == CborBase::TypeBytes)
+        && (head.getMinorType() != CborBase::TypeIndefinite)
+        && (progress + head.getLength() <= maxLength)
+        && (head.getValue() <= maxLength - progress - head.getLength()))
+    {
+        *pointer = &cbor[progress + head.getLength()];
+        *length = head.getValue();
+
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+bool CborgCursor::getString(const char** pointer, uint32_t* length) const
+{
+    uint64_t value;
+
+    if (getString(pointer, &value) && (value <= std::numeric_limits<uint32_t>::max()))
+    {
+        *length = value;
+
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+bool CborgCursor::getString(const char** pointer, uint64_t* length) const
+{
+    // definite length strings that fit in the buffer
+    if ((getType() == CborBase::TypeString)
+        && (head.getMinorType() != CborBase::TypeIndefinite)
+        && (progress + head.getLength() <= maxLength)
+        && (head.getValue() <= maxLength - progress - head.getLength()))
+    {
+        *pointer = (const char*) &cbor[progress + head.getLength()];
+        *length = head.getValue();
+
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+bool CborgCursor::getString(std::string& str) const
+{
+    const char* pointer = NULL;
+    uint64_t length = 0;
+
+    if (getString(&pointer, &length))
+    {
+        str.assign(pointer, (std::size_t) length);
+
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+Cborg CborgCursor::getCborg() const
+{
+    if (end)
+    {
+        return Cborg(NULL, 0);
+    }
+
+    return Cborg(&cbor[progress], maxLength - progress);
+}
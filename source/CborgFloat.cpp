@@ -0,0 +1,358 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cborg/CborgFloat.h"
+#include "cborg/CborBase.h"
+
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define CBORG_FLOAT_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+    uint32_t floatBits(float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+
+        return bits;
+    }
+
+    float bitsFloat(uint32_t bits)
+    {
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+
+        return value;
+    }
+
+    uint64_t doubleBits(double value)
+    {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+
+        return bits;
+    }
+
+#if defined(CBORG_FLOAT_X86)
+    /*************************************************************************/
+    /* F16C                                                                  */
+    /*************************************************************************/
+
+    __attribute__((target("avx,f16c")))
+    void halfToFloatF16C(const uint16_t* source, float* destination, std::size_t count)
+    {
+        std::size_t idx = 0;
+
+        for (; idx + 8 <= count; idx += 8)
+        {
+            __m128i half = _mm_loadu_si128((const __m128i*) &source[idx]);
+            _mm256_storeu_ps(&destination[idx], _mm256_cvtph_ps(half));
+        }
+
+        // convert the tail through a padded block to stay in AVX code
+        if (idx < count)
+        {
+            uint16_t block[8] = { 0 };
+            float result[8];
+
+            memcpy(block, &source[idx], (count - idx) * sizeof(uint16_t));
+            _mm256_storeu_ps(result, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*) block)));
+            memcpy(&destination[idx], result, (count - idx) * sizeof(float));
+        }
+    }
+
+    __attribute__((target("avx,f16c")))
+    void floatToHalfF16C(const float* source, uint16_t* destination, std::size_t count)
+    {
+        std::size_t idx = 0;
+
+        for (; idx + 8 <= count; idx += 8)
+        {
+            __m128i half = _mm256_cvtps_ph(_mm256_loadu_ps(&source[idx]), _MM_FROUND_TO_NEAREST_INT);
+            _mm_storeu_si128((__m128i*) &destination[idx], half);
+        }
+
+        if (idx < count)
+        {
+            float block[8] = { 0 };
+            uint16_t result[8];
+
+            memcpy(block, &source[idx], (count - idx) * sizeof(float));
+            _mm_storeu_si128((__m128i*) result, _mm256_cvtps_ph(_mm256_loadu_ps(block), _MM_FROUND_TO_NEAREST_INT));
+            memcpy(&destination[idx], result, (count - idx) * sizeof(uint16_t));
+        }
+    }
+#endif
+
+    /*************************************************************************/
+    /* Dispatch                                                              */
+    /*************************************************************************/
+
+    CborgFloat::Convert_t detect()
+    {
+#if defined(CBORG_FLOAT_X86)
+        __builtin_cpu_init();
+
+        if (__builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c"))
+        {
+            return CborgFloat::ConvertF16C;
+        }
+#endif
+
+        return CborgFloat::ConvertScalar;
+    }
+
+    // best implementation supported by the CPU
+    const CborgFloat::Convert_t supported = detect();
+
+    CborgFloat::Convert_t selected = supported;
+}
+
+/*****************************************************************************/
+/* Scalar                                                                    */
+/*****************************************************************************/
+
+float CborgFloat::halfToFloat(uint16_t half)
+{
+    uint32_t sign = (uint32_t) (half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1F;
+    uint32_t mantissa = half & 0x03FF;
+
+    if (exponent == 0x1F)
+    {
+        // infinity, or NaN made quiet
+        return bitsFloat(sign | 0x7F800000 | (mantissa << 13) | ((mantissa) ? 0x00400000 : 0));
+    }
+    else if (exponent > 0)
+    {
+        // rebias exponent from 15 to 127
+        return bitsFloat(sign | ((exponent + 112) << 23) | (mantissa << 13));
+    }
+    else if (mantissa == 0)
+    {
+        return bitsFloat(sign);
+    }
+
+    // subnormal half is a normal float, shift the leading one into place
+    exponent = 113;
+
+    while ((mantissa & 0x0400) == 0)
+    {
+        mantissa <<= 1;
+        exponent--;
+    }
+
+    return bitsFloat(sign | (exponent << 23) | ((mantissa & 0x03FF) << 13));
+}
+
+double CborgFloat::halfToDouble(uint16_t half)
+{
+    // every half precision value is exact in single precision
+    return halfToFloat(half);
+}
+
+uint16_t CborgFloat::floatToHalf(float value)
+{
+    uint32_t bits = floatBits(value);
+
+    uint16_t sign = (bits >> 16) & 0x8000;
+    uint32_t exponent = (bits >> 23) & 0xFF;
+    uint32_t mantissa = bits & 0x007FFFFF;
+
+    if (exponent == 0xFF)
+    {
+        // infinity, or quiet NaN with the top of the payload
+        return sign | 0x7C00 | ((mantissa) ? (0x0200 | (mantissa >> 13)) : 0);
+    }
+
+    int32_t rebased = (int32_t) exponent - 112;
+
+    if (rebased >= 0x1F)
+    {
+        // too large, infinity
+        return sign | 0x7C00;
+    }
+
+    uint32_t half;
+    uint32_t remainder;
+    uint32_t halfway;
+
+    if (rebased > 0)
+    {
+        half = ((uint32_t) rebased << 10) | (mantissa >> 13);
+        remainder = mantissa & 0x1FFF;
+        halfway = 0x1000;
+    }
+    else if (rebased >= -10)
+    {
+        // subnormal half, the implicit one becomes part of the mantissa
+        uint32_t shift = 14 - rebased;
+
+        mantissa |= 0x00800000;
+        half = mantissa >> shift;
+        remainder = mantissa & ((1UL << shift) - 1);
+        halfway = 1UL << (shift - 1);
+    }
+    else
+    {
+        // too small, zero
+        return sign;
+    }
+
+    // round to nearest even, a carry moves into the exponent as it should
+    if ((remainder > halfway) || ((remainder == halfway) && (half & 1)))
+    {
+        half++;
+    }
+
+    return sign | half;
+}
+
+/*****************************************************************************/
+/* Bulk                                                                      */
+/*****************************************************************************/
+
+void CborgFloat::halfToFloat(const uint16_t* source, float* destination, std::size_t count)
+{
+#if defined(CBORG_FLOAT_X86)
+    if (selected == ConvertF16C)
+    {
+        halfToFloatF16C(source, destination, count);
+
+        return;
+    }
+#endif
+
+    for (std::size_t idx = 0; idx < count; idx++)
+    {
+        destination[idx] = halfToFloat(source[idx]);
+    }
+}
+
+void CborgFloat::floatToHalf(const float* source, uint16_t* destination, std::size_t count)
+{
+#if defined(CBORG_FLOAT_X86)
+    if (selected == ConvertF16C)
+    {
+        floatToHalfF16C(source, destination, count);
+
+        return;
+    }
+#endif
+
+    for (std::size_t idx = 0; idx < count; idx++)
+    {
+        destination[idx] = floatToHalf(source[idx]);
+    }
+}
+
+/*****************************************************************************/
+/* Shortest encoding                                                         */
+/*****************************************************************************/
+
+uint8_t CborgFloat::shortest(double value, uint64_t* bits)
+{
+    float single = (float) value;
+
+    if (doubleBits((double) single) != doubleBits(value))
+    {
+        *bits = doubleBits(value);
+
+        return CborBase::TypeDoubleFloat;
+    }
+
+    return shortest(single, bits);
+}
+
+uint8_t CborgFloat::shortest(float value, uint64_t* bits)
+{
+    uint16_t half = floatToHalf(value);
+
+    if (floatBits(halfToFloat(half)) == floatBits(value))
+    {
+        *bits = half;
+
+        return CborBase::TypeHalfFloat;
+    }
+
+    *bits = floatBits(value);
+
+    return CborBase::TypeSingleFloat;
+}
+
+/*****************************************************************************/
+/* Decoding                                                                  */
+/*****************************************************************************/
+
+bool CborgFloat::widen(uint8_t simpleType, uint64_t bits, double* value)
+{
+    if (simpleType == CborBase::TypeHalfFloat)
+    {
+        *value = halfToDouble(bits);
+    }
+    else if (simpleType == CborBase::TypeSingleFloat)
+    {
+        *value = bitsFloat(bits);
+    }
+    else if (simpleType == CborBase::TypeDoubleFloat)
+    {
+        memcpy(value, &bits, sizeof(double));
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+bool CborgFloat::narrow(uint8_t simpleType, uint64_t bits, float* value)
+{
+    double wide;
+
+    if (!widen(simpleType, bits, &wide))
+    {
+        return false;
+    }
+
+    float single = (float) wide;
+
+    // half and single precision always fit, double only if nothing is lost
+    if ((simpleType == CborBase::TypeDoubleFloat) && (doubleBits((double) single) != bits))
+    {
+        return false;
+    }
+
+    *value = single;
+
+    return true;
+}
+
+CborgFloat::Convert_t CborgFloat::getImplementation()
+{
+    return selected;
+}
+
+CborgFloat::Convert_t CborgFloat::setImplementation(Convert_t implementation)
+{
+    // never select more than the CPU supports
+    selected = (implementation < supported) ? implementation : supported;
+
+    return selected;
+}
@@ -0,0 +1,74 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cborg/CborgHeader.h"
+
+namespace {
+    constexpr uint16_t width(uint8_t minor)
+    {
+        return (minor < 24) ? 0 :
+               (minor == 24) ? 1 :
+               (minor == 25) ? 2 :
+               (minor == 26) ? 4 :
+               (minor == 27) ? 8 : 0;
+    }
+
+    constexpr bool reserved(uint8_t major, uint8_t minor)
+    {
+        // 28-30 are unassigned, 31 is only valid for strings, containers, and break
+        return ((minor >= 28) && (minor <= 30))
+            || ((minor == 31) && ((major == CborBase::TypeUnsigned)
+                                 || (major == CborBase::TypeNegative)
+                                 || (major == CborBase::TypeTag)));
+    }
+
+    constexpr uint16_t entry(uint8_t major, uint8_t minor)
+    {
+        return (major << CborgHeader::InfoMajorShift)
+             | width(minor)
+             | (((major == CborBase::TypeArray) || (major == CborBase::TypeMap))
+                    ? CborgHeader::InfoContainer : 0)
+             | ((minor == 31)
+                    ? CborgHeader::InfoIndefinite : 0)
+             | ((((major == CborBase::TypeBytes) || (major == CborBase::TypeString)) && (minor != 31))
+                    ? CborgHeader::InfoPayload : 0)
+             | (reserved(major, minor)
+                    ? CborgHeader::InfoReserved : 0)
+             | (((major == CborBase::TypeArray) || (major == CborBase::TypeMap)
+                || (((major == CborBase::TypeBytes) || (major == CborBase::TypeString)) && (minor == 31)))
+                    ? CborgHeader::InfoNested : 0);
+    }
+
+    constexpr uint16_t initialInfo(unsigned initial)
+    {
+        return entry(initial >> 5, initial & 31);
+    }
+}
+
+#define CBORG_INFO_4(initial)   initialInfo(initial), initialInfo((initial) + 1), \
+                                initialInfo((initial) + 2), initialInfo((initial) + 3)
+#define CBORG_INFO_16(initial)  CBORG_INFO_4(initial), CBORG_INFO_4((initial) + 4), \
+                                CBORG_INFO_4((initial) + 8), CBORG_INFO_4((initial) + 12)
+#define CBORG_INFO_64(initial)  CBORG_INFO_16(initial), CBORG_INFO_16((initial) + 16), \
+                                CBORG_INFO_16((initial) + 32), CBORG_INFO_16((initial) + 48)
+
+// table is computed at compile time
+const uint16_t CborgHeader::table[256] = {
+    CBORG_INFO_64(0),
+    CBORG_INFO_64(64),
+    CBORG_INFO_64(128),
+    CBORG_INFO_64(192)
+};
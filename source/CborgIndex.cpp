@@ -0,0 +1,352 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cborg/CborgIndex.h"
+#include "cborg/CborgStack.h"
+#include "cborg/CborgTraverse.h"
+
+#include <limits>
+
+#if 0
+#include <stdio.h>
+#define DEBUG_PRINTF(...) { printf(__VA_ARGS__); }
+#else
+#define DEBUG_PRINTF(...)
+#endif
+
+namespace {
+    /*
+        Append an entry for every item, fill in subtree end and next
+        sibling when a container is complete.
+    */
+    class CborgIndexBuilder
+    {
+    public:
+        CborgIndexBuilder(const uint8_t* _cbor, std::vector<CborgIndex::Entry_t>& _entries)
+            :   cbor(_cbor),
+                entries(_entries),
+                tagged(false),
+                tagOffset(0)
+        {}
+
+        bool item(const uint8_t* pointer, const CborgHeader& head, std::size_t)
+        {
+            uint8_t type = head.getMajorType();
+            uint8_t simple = head.getMinorType();
+
+            // second tag on the same item, only the tagged item is indexed
+            // but it starts at the first tag, like it does for Cborg
+            if (type == CborBase::TypeTag)
+            {
+                if (!tagged)
+                {
+                    tagged = true;
+                    tagOffset = pointer - cbor;
+                }
+
+                return true;
+            }
+
+            uint32_t position = entries.size();
+            uint32_t start = pointer - cbor;
+            uint32_t offset = (tagged) ? tagOffset : start;
+
+            tagged = false;
+
+            CborgIndex::Entry_t current = { offset, 0, 0, 0, 0 };
+            entries.push_back(current);
+
+            if (list.size() > 0)
+            {
+                entries[list.back()].size++;
+            }
+
+            if ((type == CborBase::TypeMap) || (type == CborBase::TypeArray)
+                || (((type == CborBase::TypeBytes) || (type == CborBase::TypeString))
+                    && (simple == CborBase::TypeIndefinite)))
+            {
+                // completed in leave()
+                return list.push_back(position);
+            }
+            else if ((type == CborBase::TypeBytes) || (type == CborBase::TypeString))
+            {
+                // offsets are 32-bit, the traversal rejects payloads beyond the buffer
+                entries[position].end = start + head.getLength() + (uint32_t) head.getValue();
+            }
+            else
+            {
+                entries[position].end = start + head.getLength();
+            }
+
+            entries[position].next = position + 1;
+
+            return true;
+        }
+
+        void leave(const uint8_t* end, std::size_t)
+        {
+            entries[list.back()].end = end - cbor;
+            entries[list.back()].next = entries.size();
+            list.pop_back();
+        }
+
+    private:
+        const uint8_t* cbor;
+        std::vector<CborgIndex::Entry_t>& entries;
+
+        // entries of open containers, the traversal itself rejects deeper nesting
+        CborgStack<uint32_t, CBORG_MAX_DEPTH + 1> list;
+
+        // start of the tags in front of the next item
+        bool tagged;
+        uint32_t tagOffset;
+    };
+}
+
+CborgIndex::CborgIndex()
+    :   cbor(NULL),
+        maxLength(0)
+{}
+
+bool CborgIndex::build(const uint8_t* _cbor, std::size_t _maxLength)
+{
+    clear();
+
+    // entries store 32-bit offsets
+    if ((_cbor == NULL) || (_maxLength == 0) || (_maxLength > std::numeric_limits<uint32_t>::max()))
+    {
+        return false;
+    }
+
+    cbor = _cbor;
+    maxLength = _maxLength;
+
+    CborgIndexBuilder builder(cbor, entries);
+    std::size_t length = 0;
+
+    if (CborgTraverse::visit(cbor, maxLength, builder, &length) != CborgTraverse::StatusOk)
+    {
+        // buffer truncated or malformed
+        clear();
+
+        return false;
+    }
+
+    // list direct children of each container back to back
+    table.resize(entries.size());
+    uint32_t slot = 0;
+
+    for (std::size_t idx = 0; idx < entries.size(); idx++)
+    {
+        entries[idx].children = slot;
+
+        uint32_t child = idx + 1;
+
+        for (std::size_t count = 0; count < entries[idx].size; count++)
+        {
+            table[slot++] = child;
+            child = entries[child].next;
+        }
+    }
+
+    DEBUG_PRINTF("index: %u entries\r\n", (unsigned) entries.size());
+
+    return true;
+}
+
+void CborgIndex::clear()
+{
+    cbor = NULL;
+    maxLength = 0;
+
+    entries.clear();
+    table.clear();
+}
+
+CborgIndexed CborgIndex::root() const
+{
+    if (entries.size() > 0)
+    {
+        return CborgIndexed(this, 0);
+    }
+
+    return CborgIndexed();
+}
+
+std::size_t CborgIndex::getEntries() const
+{
+    return entries.size();
+}
+
+/*****************************************************************************/
+/* Indexed decoder                                                           */
+/*****************************************************************************/
+
+CborgIndexed::CborgIndexed()
+    :   index(NULL),
+        entry(0)
+{}
+
+CborgIndexed::CborgIndexed(const CborgIndex* _index, uint32_t _entry)
+    :   index(_index),
+        entry(_entry)
+{}
+
+bool CborgIndexed::getCBOR(const uint8_t** pointer, uint32_t* length) const
+{
+    if (index)
+    {
+        const CborgIndex::Entry_t& current = index->entries[entry];
+
+        *pointer = &index->cbor[current.offset];
+        *length = current.end - current.offset;
+
+        return true;
+    }
+
+    return false;
+}
+
+std::size_t CborgIndexed::getCBORLength() const
+{
+    if (index)
+    {
+        const CborgIndex::Entry_t& current = index->entries[entry];
+
+        return current.end - current.offset;
+    }
+
+    return 0;
+}
+
+CborgIndexed CborgIndexed::find(int32_t key) const
+{
+    return find(CborgKey(key));
+}
+
+CborgIndexed CborgIndexed::find(const char* key, std::size_t keyLength) const
+{
+    // only continue if key is not NULL
+    if (key == NULL)
+    {
+        return CborgIndexed();
+    }
+
+    return find(CborgKey(key, keyLength));
+}
+
+CborgIndexed CborgIndexed::find(const CborgKey& key) const
+{
+    if (getType() != CborBase::TypeMap)
+    {
+        return CborgIndexed();
+    }
+
+    const CborgIndex::Entry_t& current = index->entries[entry];
+
+    // keys are on even positions, values on odd
+    for (std::size_t idx = 0; idx + 1 < current.size; idx += 2)
+    {
+        uint32_t position = index->table[current.children + idx];
+        const uint8_t* pointer = &index->cbor[index->entries[position].offset];
+
+        CborgHeader head;
+        head.decode(pointer);
+
+        if (key.matches(pointer, head))
+        {
+            return CborgIndexed(index, index->table[current.children + idx + 1]);
+        }
+    }
+
+    return CborgIndexed();
+}
+
+CborgIndexed CborgIndexed::at(std::size_t position) const
+{
+    if (getType() != CborBase::TypeArray)
+    {
+        return CborgIndexed();
+    }
+
+    const CborgIndex::Entry_t& current = index->entries[entry];
+
+    if (position >= current.size)
+    {
+        return CborgIndexed();
+    }
+
+    return CborgIndexed(index, index->table[current.children + position]);
+}
+
+uint32_t CborgIndexed::getSize() const
+{
+    if (index)
+    {
+        uint8_t type = getType();
+
+        if (type == CborBase::TypeMap)
+        {
+            return index->entries[entry].size / 2;
+        }
+        else if (type == CborBase::TypeArray)
+        {
+            return index->entries[entry].size;
+        }
+    }
+
+    return getCborg().getSize();
+}
+
+Cborg CborgIndexed::getCborg() const
+{
+    if (index)
+    {
+        const CborgIndex::Entry_t& current = index->entries[entry];
+
+        return Cborg(&index->cbor[current.offset], current.end - current.offset);
+    }
+
+    return Cborg(NULL, 0);
+}
+
+/*****************************************************************************/
+/* Header related                                                            */
+/*****************************************************************************/
+
+uint32_t CborgIndexed::getTag() const
+{
+    return getCborg().getTag();
+}
+
+uint8_t CborgIndexed::getType() const
+{
+    return getCborg().getType();
+}
+
+uint8_t CborgIndexed::getMinorType() const
+{
+    return getCborg().getMinorType();
+}
+
+/*****************************************************************************/
+/* Debug related                                                             */
+/*****************************************************************************/
+
+void CborgIndexed::print() const
+{
+    getCborg().print();
+}
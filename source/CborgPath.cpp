@@ -0,0 +1,314 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cborg/CborgPath.h"
+#include "cborg/CborgTraverse.h"
+
+#include <string.h>
+
+namespace {
+    // initial byte of the break marker ending indefinite containers
+    const uint8_t breakByte = CborBase::TypeSpecial << 5 | CborBase::TypeIndefinite;
+
+    // skip one item, without any checks if the buffer has been validated
+    bool skipItem(const uint8_t* cbor, std::size_t maxLength, bool validated, std::size_t* length)
+    {
+        if (validated)
+        {
+            *length = CborgTraverse::skipUnchecked(cbor);
+
+            return true;
+        }
+
+        return (CborgTraverse::skip(cbor, maxLength, length) == CborgTraverse::StatusOk);
+    }
+}
+
+CborgPath::CborgPath()
+    :   valid(false)
+{}
+
+CborgPath::CborgPath(const char* _path)
+    :   valid(false)
+{
+    compile(_path);
+}
+
+bool CborgPath::compile(const char* _path)
+{
+    if (_path == NULL)
+    {
+        return compile(NULL, 0);
+    }
+
+    return compile(_path, strlen(_path));
+}
+
+bool CborgPath::compile(const char* _path, std::size_t length)
+{
+    steps = CborgStack<Entry_t>();
+    valid = false;
+
+    if (_path == NULL)
+    {
+        path.clear();
+
+        return false;
+    }
+
+    path.assign(_path, length);
+
+    std::size_t position = 0;
+
+    while (position < length)
+    {
+        Entry_t step = { StepString, 0, 0, 0 };
+
+        if (path[position] == '[')
+        {
+            step.type = StepIndex;
+            position++;
+
+            if (!parseNumber(&position, ']', false, &step.value))
+            {
+                return false;
+            }
+        }
+        else if (path[position] == '{')
+        {
+            step.type = StepInteger;
+            position++;
+
+            if (!parseNumber(&position, '}', true, &step.value))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            // names are separated by '.' except at the start of the path
+            if (steps.size() > 0)
+            {
+                if (path[position] != '.')
+                {
+                    return false;
+                }
+
+                position++;
+            }
+
+            step.offset = position;
+
+            while ((position < length)
+                   && (path[position] != '.')
+                   && (path[position] != '[')
+                   && (path[position] != '{'))
+            {
+                position++;
+            }
+
+            step.length = position - step.offset;
+
+            if (step.length == 0)
+            {
+                return false;
+            }
+        }
+
+        // paths deeper than the traversal supports are rejected
+        if (!steps.push_back(step))
+        {
+            return false;
+        }
+    }
+
+    valid = true;
+
+    return true;
+}
+
+bool CborgPath::parseNumber(std::size_t* position, char end, bool sign, int32_t* value) const
+{
+    bool negative = false;
+
+    if (sign && (*position < path.length()) && (path[*position] == '-'))
+    {
+        negative = true;
+        (*position)++;
+    }
+
+    int64_t result = 0;
+    std::size_t digits = 0;
+
+    while ((*position < path.length()) && (path[*position] >= '0') && (path[*position] <= '9'))
+    {
+        result = result * 10 + (path[*position] - '0');
+        digits++;
+        (*position)++;
+
+        if (result > ((int64_t) INT32_MAX + 1))
+        {
+            return false;
+        }
+    }
+
+    if ((digits == 0) || (*position >= path.length()) || (path[*position] != end))
+    {
+        return false;
+    }
+
+    // skip end marker
+    (*position)++;
+
+    if (negative)
+    {
+        result = -result;
+    }
+    else if (result > INT32_MAX)
+    {
+        return false;
+    }
+
+    *value = (int32_t) result;
+
+    return true;
+}
+
+bool CborgPath::isValid() const
+{
+    return valid;
+}
+
+std::size_t CborgPath::getSteps() const
+{
+    return steps.size();
+}
+
+Cborg CborgPath::evaluate(const uint8_t* cbor, std::size_t maxLength) const
+{
+    std::size_t offset = 0;
+
+    if (locate(cbor, maxLength, false, &offset))
+    {
+        return Cborg(&cbor[offset], maxLength - offset);
+    }
+
+    return Cborg(NULL, 0);
+}
+
+bool CborgPath::locate(const uint8_t* cbor, std::size_t maxLength, bool validated, std::size_t* offset) const
+{
+    if ((!valid) || (cbor == NULL))
+    {
+        return false;
+    }
+
+    CborgHeader head;
+    std::size_t progress = 0;
+
+    for (std::size_t idx = 0; idx < steps.size(); idx++)
+    {
+        const Entry_t& step = steps[idx];
+
+        if ((progress >= maxLength) || !head.decode(&cbor[progress], maxLength - progress))
+        {
+            return false;
+        }
+
+        bool map = (step.type != StepIndex);
+        bool indefinite = (head.getMinorType() == CborBase::TypeIndefinite);
+        std::size_t units = (std::size_t) head.getValue();
+
+        // only continue if container has the right type and index is within bounds
+        if ((head.getMajorType() != (map ? CborBase::TypeMap : CborBase::TypeArray))
+            || ((!map) && (!indefinite) && ((uint32_t) step.value >= head.getValue())))
+        {
+            return false;
+        }
+
+        CborgKey key = (step.type == StepString) ? CborgKey(&path[step.offset], step.length)
+                                                 : CborgKey(step.value);
+
+        // skip container header
+        progress += head.getLength();
+
+        bool found = false;
+        uint32_t position = 0;
+
+        // stop when maximum length is reached or the current container is finished
+        while ((indefinite || (units > 0)) && (progress < maxLength))
+        {
+            if (indefinite && (cbor[progress] == breakByte))
+            {
+                break;
+            }
+
+            std::size_t length = 0;
+
+            if (map)
+            {
+                const uint8_t* pointer = &cbor[progress];
+
+                // skip key, the key header is within bounds once it has been skipped
+                if (!skipItem(pointer, maxLength - progress, validated, &length))
+                {
+                    break;
+                }
+
+                head.decode(pointer);
+                progress += length;
+
+                // descend into value
+                if (key.matches(pointer, head))
+                {
+                    found = true;
+                    break;
+                }
+            }
+            else if (position == (uint32_t) step.value)
+            {
+                // descend into element
+                found = true;
+                break;
+            }
+
+            // skip value or element
+            if ((progress >= maxLength)
+                || !skipItem(&cbor[progress], maxLength - progress, validated, &length))
+            {
+                break;
+            }
+
+            progress += length;
+            position++;
+            units--;
+        }
+
+        if (!found)
+        {
+            return false;
+        }
+    }
+
+    if (progress >= maxLength)
+    {
+        return false;
+    }
+
+    *offset = progress;
+
+    return true;
+}
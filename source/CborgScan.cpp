@@ -0,0 +1,357 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cborg/CborgScan.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define CBORG_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+    /*************************************************************************/
+    /* Scalar                                                                */
+    /*************************************************************************/
+
+    std::size_t immediatesScalar(const uint8_t* data, std::size_t length)
+    {
+        std::size_t count = 0;
+
+        while ((count < length) && CborgScan::isImmediate(data[count]))
+        {
+            count++;
+        }
+
+        return count;
+    }
+
+    /*
+        Validate multi-byte sequences, position is at a byte >= 0x80.
+        Returns the length of the sequence or 0 if it is invalid.
+    */
+    std::size_t sequence(const uint8_t* data, std::size_t length)
+    {
+        uint8_t first = data[0];
+        std::size_t size;
+        uint8_t low = 0x80;
+        uint8_t high = 0xBF;
+
+        if ((first >= 0xC2) && (first <= 0xDF))
+        {
+            size = 2;
+        }
+        else if ((first >= 0xE0) && (first <= 0xEF))
+        {
+            size = 3;
+
+            // no overlong encodings and no surrogates
+            if (first == 0xE0)
+            {
+                low = 0xA0;
+            }
+            else if (first == 0xED)
+            {
+                high = 0x9F;
+            }
+        }
+        else if ((first >= 0xF0) && (first <= 0xF4))
+        {
+            size = 4;
+
+            // no overlong encodings and nothing above U+10FFFF
+            if (first == 0xF0)
+            {
+                low = 0x90;
+            }
+            else if (first == 0xF4)
+            {
+                high = 0x8F;
+            }
+        }
+        else
+        {
+            return 0;
+        }
+
+        if ((size > length) || (data[1] < low) || (data[1] > high))
+        {
+            return 0;
+        }
+
+        for (std::size_t idx = 2; idx < size; idx++)
+        {
+            if ((data[idx] & 0xC0) != 0x80)
+            {
+                return 0;
+            }
+        }
+
+        return size;
+    }
+
+    bool utf8Scalar(const uint8_t* data, std::size_t length)
+    {
+        std::size_t position = 0;
+
+        while (position < length)
+        {
+            if (data[position] < 0x80)
+            {
+                position++;
+            }
+            else
+            {
+                std::size_t size = sequence(&data[position], length - position);
+
+                if (size == 0)
+                {
+                    return false;
+                }
+
+                position += size;
+            }
+        }
+
+        return true;
+    }
+
+#if defined(CBORG_SCAN_X86)
+    /*************************************************************************/
+    /* SSE2                                                                  */
+    /*************************************************************************/
+
+    // bit set for every byte that is not a one byte item
+    inline uint32_t rejectSSE2(__m128i bytes)
+    {
+        const __m128i minorMask = _mm_set1_epi8(0x1F);
+        const __m128i majorMask = _mm_set1_epi8((char) 0xE0);
+        const __m128i minorMax = _mm_set1_epi8(23);
+
+        __m128i minor = _mm_and_si128(bytes, minorMask);
+        __m128i major = _mm_and_si128(bytes, majorMask);
+
+        // minor <= 23 as unsigned comparison
+        __m128i small = _mm_cmpeq_epi8(_mm_min_epu8(minor, minorMax), minor);
+
+        // major type 0, 1, or 7
+        __m128i types = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(major, _mm_setzero_si128()),
+                                                  _mm_cmpeq_epi8(major, _mm_set1_epi8(0x20))),
+                                     _mm_cmpeq_epi8(major, majorMask));
+
+        return ~_mm_movemask_epi8(_mm_and_si128(small, types)) & 0xFFFF;
+    }
+
+    std::size_t immediatesSSE2(const uint8_t* data, std::size_t length)
+    {
+        std::size_t count = 0;
+
+        while (count + 16 <= length)
+        {
+            uint32_t reject = rejectSSE2(_mm_loadu_si128((const __m128i*) &data[count]));
+
+            if (reject)
+            {
+                return count + __builtin_ctz(reject);
+            }
+
+            count += 16;
+        }
+
+        return count + immediatesScalar(&data[count], length - count);
+    }
+
+    bool utf8SSE2(const uint8_t* data, std::size_t length)
+    {
+        std::size_t position = 0;
+
+        while (position < length)
+        {
+            // skip ASCII 16 bytes at a time
+            if ((position + 16 <= length)
+                && (_mm_movemask_epi8(_mm_loadu_si128((const __m128i*) &data[position])) == 0))
+            {
+                position += 16;
+            }
+            else if (data[position] < 0x80)
+            {
+                position++;
+            }
+            else
+            {
+                std::size_t size = sequence(&data[position], length - position);
+
+                if (size == 0)
+                {
+                    return false;
+                }
+
+                position += size;
+            }
+        }
+
+        return true;
+    }
+
+    /*************************************************************************/
+    /* AVX2                                                                  */
+    /*************************************************************************/
+
+    __attribute__((target("avx2")))
+    std::size_t immediatesAVX2(const uint8_t* data, std::size_t length)
+    {
+        const __m256i minorMask = _mm256_set1_epi8(0x1F);
+        const __m256i majorMask = _mm256_set1_epi8((char) 0xE0);
+        const __m256i minorMax = _mm256_set1_epi8(23);
+        const __m256i negative = _mm256_set1_epi8(0x20);
+
+        std::size_t count = 0;
+
+        while (count + 32 <= length)
+        {
+            __m256i bytes = _mm256_loadu_si256((const __m256i*) &data[count]);
+
+            __m256i minor = _mm256_and_si256(bytes, minorMask);
+            __m256i major = _mm256_and_si256(bytes, majorMask);
+
+            __m256i small = _mm256_cmpeq_epi8(_mm256_min_epu8(minor, minorMax), minor);
+            __m256i types = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(major, _mm256_setzero_si256()),
+                                                            _mm256_cmpeq_epi8(major, negative)),
+                                            _mm256_cmpeq_epi8(major, majorMask));
+
+            uint32_t reject = ~(uint32_t) _mm256_movemask_epi8(_mm256_and_si256(small, types));
+
+            if (reject)
+            {
+                return count + __builtin_ctz(reject);
+            }
+
+            count += 32;
+        }
+
+        // the compiler does not clear the upper halves before this call and
+        // legacy SSE code running with them dirty is several times slower
+        _mm256_zeroupper();
+
+        return count + immediatesSSE2(&data[count], length - count);
+    }
+
+    __attribute__((target("avx2")))
+    bool utf8AVX2(const uint8_t* data, std::size_t length)
+    {
+        std::size_t position = 0;
+
+        while (position < length)
+        {
+            // skip ASCII 32 bytes at a time
+            if ((position + 32 <= length)
+                && (_mm256_movemask_epi8(_mm256_loadu_si256((const __m256i*) &data[position])) == 0))
+            {
+                position += 32;
+            }
+            else if (data[position] < 0x80)
+            {
+                position++;
+            }
+            else
+            {
+                // leaving AVX code, see immediatesAVX2
+                _mm256_zeroupper();
+
+                std::size_t size = sequence(&data[position], length - position);
+
+                if (size == 0)
+                {
+                    return false;
+                }
+
+                position += size;
+            }
+        }
+
+        return true;
+    }
+#endif
+
+    /*************************************************************************/
+    /* Dispatch                                                              */
+    /*************************************************************************/
+
+    CborgScan::Scan_t detect()
+    {
+#if defined(CBORG_SCAN_X86)
+        __builtin_cpu_init();
+
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return CborgScan::ScanAVX2;
+        }
+
+        return CborgScan::ScanSSE2;
+#else
+        return CborgScan::ScanScalar;
+#endif
+    }
+
+    // best implementation supported by the CPU
+    const CborgScan::Scan_t supported = detect();
+
+    CborgScan::Scan_t selected = supported;
+}
+
+std::size_t CborgScan::immediates(const uint8_t* data, std::size_t length)
+{
+#if defined(CBORG_SCAN_X86)
+    if (selected == ScanAVX2)
+    {
+        return immediatesAVX2(data, length);
+    }
+    else if (selected == ScanSSE2)
+    {
+        return immediatesSSE2(data, length);
+    }
+#endif
+
+    return immediatesScalar(data, length);
+}
+
+bool CborgScan::utf8(const uint8_t* data, std::size_t length)
+{
+#if defined(CBORG_SCAN_X86)
+    if (selected == ScanAVX2)
+    {
+        return utf8AVX2(data, length);
+    }
+    else if (selected == ScanSSE2)
+    {
+        return utf8SSE2(data, length);
+    }
+#endif
+
+    return utf8Scalar(data, length);
+}
+
+CborgScan::Scan_t CborgScan::getImplementation()
+{
+    return selected;
+}
+
+CborgScan::Scan_t CborgScan::setImplementation(Scan_t implementation)
+{
+    // never select more than the CPU supports
+    selected = (implementation < supported) ? implementation : supported;
+
+    return selected;
+}
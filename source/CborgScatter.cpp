@@ -0,0 +1,654 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cborg/CborgScatter.h"
+#include "cborg/CborgTraverse.h"
+#include "cborg/CborgStream.h"
+
+#include <string.h>
+#include <limits>
+
+namespace {
+    // longest header: tag followed by the header of the tagged item
+    const std::size_t maxHeader = 18;
+
+    // initial byte of the break marker ending indefinite containers
+    const uint8_t breakByte = CborBase::TypeSpecial << 5 | CborBase::TypeIndefinite;
+}
+
+CborgScatter::CborgScatter()
+    :   segments(NULL),
+        count(0),
+        segment(0),
+        offset(0)
+{}
+
+CborgScatter::CborgScatter(const CborgSegment* _segments, std::size_t _count)
+    :   segments(_segments),
+        count(_count),
+        segment(0),
+        offset(0)
+{
+    // skip empty segments at the start
+    if (!advance(&segment, &offset, 0))
+    {
+        segments = NULL;
+    }
+}
+
+CborgScatter::CborgScatter(const CborgSegment* _segments, std::size_t _count, std::size_t _segment, std::size_t _offset)
+    :   segments(_segments),
+        count(_count),
+        segment(_segment),
+        offset(_offset)
+{}
+
+/*****************************************************************************/
+/* Segment handling                                                          */
+/*****************************************************************************/
+
+/*
+    Move position forward, returns false if it moves past the last segment.
+*/
+bool CborgScatter::advance(std::size_t* _segment, std::size_t* _offset, std::size_t length) const
+{
+    std::size_t position = *_offset + length;
+    std::size_t current = *_segment;
+
+    while ((current < count) && (position >= segments[current].length))
+    {
+        position -= segments[current].length;
+        current++;
+    }
+
+    *_segment = current;
+    *_offset = position;
+
+    return (current < count) || (position == 0);
+}
+
+std::size_t CborgScatter::gather(std::size_t _segment, std::size_t _offset, uint8_t* destination, std::size_t length) const
+{
+    std::size_t copied = 0;
+
+    while ((copied < length) && (_segment < count))
+    {
+        std::size_t part = segments[_segment].length - _offset;
+
+        if (part > length - copied)
+        {
+            part = length - copied;
+        }
+
+        memcpy(&destination[copied], &segments[_segment].data[_offset], part);
+        copied += part;
+
+        _segment++;
+        _offset = 0;
+    }
+
+    return copied;
+}
+
+bool CborgScatter::equals(std::size_t _segment, std::size_t _offset, const char* string, std::size_t length) const
+{
+    std::size_t compared = 0;
+
+    while (compared < length)
+    {
+        if (_segment >= count)
+        {
+            return false;
+        }
+
+        std::size_t part = segments[_segment].length - _offset;
+
+        if (part > length - compared)
+        {
+            part = length - compared;
+        }
+
+        if (memcmp(&string[compared], &segments[_segment].data[_offset], part) != 0)
+        {
+            return false;
+        }
+
+        compared += part;
+
+        _segment++;
+        _offset = 0;
+    }
+
+    return true;
+}
+
+/*
+    Decode header at position, gathering it first if it straddles segments.
+*/
+bool CborgScatter::header(std::size_t _segment, std::size_t _offset, CborgHeader& head) const
+{
+    if ((segments == NULL) || (_segment >= count))
+    {
+        head.decode(NULL);
+
+        return false;
+    }
+
+    const uint8_t* pointer = &segments[_segment].data[_offset];
+    std::size_t available = segments[_segment].length - _offset;
+
+    uint8_t local[maxHeader];
+
+    if (available < maxHeader)
+    {
+        memset(local, 0, sizeof(local));
+
+        available = gather(_segment, _offset, local, sizeof(local));
+        pointer = local;
+    }
+
+    head.decode(pointer);
+
+    return (head.getLength() <= available);
+}
+
+/*
+    Skip one item. Items within one segment are skipped in place, items
+    crossing segment boundaries are fed to an incremental decoder.
+*/
+bool CborgScatter::skip(std::size_t* _segment, std::size_t* _offset) const
+{
+    if ((segments == NULL) || (*_segment >= count))
+    {
+        return false;
+    }
+
+    const CborgSegment& current = segments[*_segment];
+    std::size_t available = current.length - *_offset;
+    std::size_t length = 0;
+
+    // headers are only decoded where they can not reach past the segment
+    if ((available > maxHeader)
+        && (CborgTraverse::skip(&current.data[*_offset], available - maxHeader + 1, &length) == CborgTraverse::StatusOk))
+    {
+        return advance(_segment, _offset, length);
+    }
+
+    CborgStream stream;
+    std::size_t position = *_offset;
+
+    for (std::size_t idx = *_segment; idx < count; idx++)
+    {
+        std::size_t consumed = 0;
+        CborgTraverse::Status_t status = stream.feed(&segments[idx].data[position], segments[idx].length - position, &consumed);
+
+        if (status == CborgTraverse::StatusOk)
+        {
+            return advance(_segment, _offset, stream.getLength());
+        }
+        else if (status != CborgTraverse::StatusTruncated)
+        {
+            break;
+        }
+
+        position = 0;
+    }
+
+    return false;
+}
+
+bool CborgScatter::payload(uint8_t type, std::size_t* _segment, std::size_t* _offset, uint32_t* length) const
+{
+    CborgHeader head;
+
+    // payloads are addressed with 32-bit lengths
+    if (!header(segment, offset, head)
+        || (head.getMajorType() != type)
+        || (head.getMinorType() == CborBase::TypeIndefinite)
+        || (head.getValue() > std::numeric_limits<uint32_t>::max()))
+    {
+        return false;
+    }
+
+    *_segment = segment;
+    *_offset = offset;
+    *length = head.getValue();
+
+    return advance(_segment, _offset, head.getLength());
+}
+
+/*****************************************************************************/
+/* Decoder                                                                   */
+/*****************************************************************************/
+
+std::size_t CborgScatter::getCBORLength() const
+{
+    std::size_t current = segment;
+    std::size_t position = offset;
+
+    if (!skip(&current, &position))
+    {
+        return 0;
+    }
+
+    // sum of segment lengths between start and end
+    std::size_t length = position;
+
+    for (std::size_t idx = segment; idx < current; idx++)
+    {
+        length += segments[idx].length;
+    }
+
+    return length - offset;
+}
+
+CborgScatter CborgScatter::find(int32_t key) const
+{
+    return find(CborgKey(key));
+}
+
+CborgScatter CborgScatter::find(const char* key, std::size_t keyLength) const
+{
+    // only continue if key is not NULL
+    if (key == NULL)
+    {
+        return CborgScatter();
+    }
+
+    return find(CborgKey(key, keyLength));
+}
+
+CborgScatter CborgScatter::find(const CborgKey& key) const
+{
+    // string keys are compared across segments
+    class Segmented
+    {
+    public:
+        Segmented(const CborgScatter& _scatter, std::size_t _segment, std::size_t _offset, const CborgHeader& _head)
+            :   scatter(_scatter),
+                segment(_segment),
+                offset(_offset),
+                head(_head)
+        {}
+
+        bool operator()(const char* string, std::size_t length) const
+        {
+            std::size_t keySegment = segment;
+            std::size_t keyOffset = offset;
+
+            return scatter.advance(&keySegment, &keyOffset, head.getLength())
+                && scatter.equals(keySegment, keyOffset, string, length);
+        }
+
+    private:
+        const CborgScatter& scatter;
+        std::size_t segment;
+        std::size_t offset;
+        const CborgHeader& head;
+    };
+
+    CborgHeader head;
+
+    // only continue if type is Cbor Map
+    if (!header(segment, offset, head) || (head.getMajorType() != CborBase::TypeMap))
+    {
+        return CborgScatter();
+    }
+
+    bool indefinite = (head.getMinorType() == CborBase::TypeIndefinite);
+    std::size_t units = (std::size_t) head.getValue();
+
+    std::size_t current = segment;
+    std::size_t position = offset;
+
+    // skip map header
+    if (!advance(&current, &position, head.getLength()))
+    {
+        return CborgScatter();
+    }
+
+    while ((indefinite || (units > 0)) && (current < count))
+    {
+        if (indefinite && (segments[current].data[position] == breakByte))
+        {
+            break;
+        }
+
+        if (!header(current, position, head))
+        {
+            break;
+        }
+
+        bool found = key.matches(head, Segmented(*this, current, position, head));
+
+        // skip key, and value unless the key matched
+        if (!skip(&current, &position) || (current >= count))
+        {
+            break;
+        }
+
+        if (found)
+        {
+            return CborgScatter(segments, count, current, position);
+        }
+
+        if (!skip(&current, &position))
+        {
+            break;
+        }
+
+        units--;
+    }
+
+    return CborgScatter();
+}
+
+CborgScatter CborgScatter::at(std::size_t index) const
+{
+    CborgHeader head;
+
+    if (!header(segment, offset, head))
+    {
+        return CborgScatter();
+    }
+
+    bool indefinite = (head.getMinorType() == CborBase::TypeIndefinite);
+
+    // only continue if container is Cbor Array and index is within bounds
+    if ((head.getMajorType() != CborBase::TypeArray)
+        || ((!indefinite) && (index >= head.getValue())))
+    {
+        return CborgScatter();
+    }
+
+    std::size_t current = segment;
+    std::size_t position = offset;
+
+    // skip array header and all elements before index
+    if (!advance(&current, &position, head.getLength()))
+    {
+        return CborgScatter();
+    }
+
+    for (std::size_t currentIndex = 0; currentIndex <= index; currentIndex++)
+    {
+        // stop when the data or the indefinite array is finished
+        if ((current >= count)
+            || (indefinite && (segments[current].data[position] == breakByte)))
+        {
+            break;
+        }
+
+        if (currentIndex == index)
+        {
+            return CborgScatter(segments, count, current, position);
+        }
+
+        if (!skip(&current, &position))
+        {
+            break;
+        }
+    }
+
+    // index not found, return null object
+    return CborgScatter();
+}
+
+uint32_t CborgScatter::getSize() const
+{
+    CborgHeader head;
+    header(segment, offset, head);
+
+    uint8_t type = head.getMajorType();
+
+    if ((type == CborBase::TypeMap)
+        || (type == CborBase::TypeArray)
+        || (type == CborBase::TypeString)
+        || (type == CborBase::TypeBytes))
+    {
+        if (head.getMinorType() == CborBase::TypeIndefinite)
+        {
+            return std::numeric_limits<uint32_t>::max();
+        }
+        else if (head.getValue() < std::numeric_limits<uint32_t>::max())
+        {
+            return head.getValue();
+        }
+        else
+        {
+            return std::numeric_limits<uint32_t>::max();
+        }
+    }
+    else
+    {
+        return 0;
+    }
+}
+
+bool CborgScatter::getUnsigned(uint32_t* integer) const
+{
+    uint64_t value;
+
+    if (getUnsigned(&value) && (value <= std::numeric_limits<uint32_t>::max()))
+    {
+        *integer = value;
+
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+bool CborgScatter::getUnsigned(uint64_t* integer) const
+{
+    CborgHeader head;
+
+    if (header(segment, offset, head) && (head.getMajorType() == CborBase::TypeUnsigned))
+    {
+        *integer = head.getValue();
+
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+bool CborgScatter::getNegative(int32_t* integer) const
+{
+    int64_t value;
+
+    if (getNegative(&value) && (value >= std::numeric_limits<int32_t>::min()))
+    {
+        *integer = value;
+
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+bool CborgScatter::getNegative(int64_t* integer) const
+{
+    CborgHeader head;
+
+    // -1 - value must not go below INT64_MIN
+    if (header(segment, offset, head) && (head.getMajorType() == CborBase::TypeNegative)
+        && (head.getValue() <= (uint64_t) std::numeric_limits<int64_t>::max()))
+    {
+        *integer = -1 - (int64_t) head.getValue();
+
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+bool CborgScatter::getInteger(int64_t* integer) const
+{
+    uint64_t value;
+
+    if (getUnsigned(&value))
+    {
+        if (value <= (uint64_t) std::numeric_limits<int64_t>::max())
+        {
+            *integer = value;
+
+            return true;
+        }
+
+        return false;
+    }
+
+    return getNegative(integer);
+}
+
+bool CborgScatter::getBytes(const uint8_t** pointer, uint32_t* length) const
+{
+    std::size_t current = 0;
+    std::size_t position = 0;
+    uint32_t size = 0;
+
+    // only payloads within a single segment can be returned in place
+    if (payload(CborBase::TypeBytes, &current, &position, &size)
+        && ((size == 0) || ((current < count) && (segments[current].length - position >= size))))
+    {
+        *pointer = (current < count) ? &segments[current].data[position] : NULL;
+        *length = size;
+
+        return true;
+    }
+
+    return false;
+}
+
+bool CborgScatter::getString(const char** pointer, uint32_t* length) const
+{
+    std::size_t current = 0;
+    std::size_t position = 0;
+    uint32_t size = 0;
+
+    // only payloads within a single segment can be returned in place
+    if (payload(CborBase::TypeString, &current, &position, &size)
+        && ((size == 0) || ((current < count) && (segments[current].length - position >= size))))
+    {
+        *pointer = (current < count) ? (const char*) &segments[current].data[position] : NULL;
+        *length = size;
+
+        return true;
+    }
+
+    return false;
+}
+
+bool CborgScatter::getString(std::string& str) const
+{
+    std::size_t current = 0;
+    std::size_t position = 0;
+    uint32_t size = 0;
+
+    if (!payload(CborBase::TypeString, &current, &position, &size))
+    {
+        return false;
+    }
+
+    str.clear();
+
+    // append the payload one segment at a time
+    while ((str.length() < size) && (current < count))
+    {
+        std::size_t part = segments[current].length - position;
+
+        if (part > size - str.length())
+        {
+            part = size - str.length();
+        }
+
+        str.append((const char*) &segments[current].data[position], part);
+
+        current++;
+        position = 0;
+    }
+
+    return (str.length() == size);
+}
+
+uint32_t CborgScatter::copyBytes(uint8_t* destination, uint32_t maxLength) const
+{
+    std::size_t current = 0;
+    std::size_t position = 0;
+    uint32_t size = 0;
+
+    if (!payload(CborBase::TypeBytes, &current, &position, &size)
+        && !payload(CborBase::TypeString, &current, &position, &size))
+    {
+        return 0;
+    }
+
+    if (size > maxLength)
+    {
+        size = maxLength;
+    }
+
+    return gather(current, position, destination, size);
+}
+
+/*****************************************************************************/
+/* Header related                                                            */
+/*****************************************************************************/
+
+uint32_t CborgScatter::getTag() const
+{
+    CborgHeader head;
+    header(segment, offset, head);
+
+    return head.getTag();
+}
+
+uint8_t CborgScatter::getType() const
+{
+    CborgHeader head;
+    header(segment, offset, head);
+
+    return head.getMajorType();
+}
+
+uint8_t CborgScatter::getMinorType() const
+{
+    CborgHeader head;
+    header(segment, offset, head);
+
+    return head.getMinorType();
+}
+
+Cborg CborgScatter::getCborg() const
+{
+    std::size_t length = getCBORLength();
+
+    if ((length > 0) && (segments[segment].length - offset >= length))
+    {
+        return Cborg(&segments[segment].data[offset], length);
+    }
+
+    return Cborg(NULL, 0);
+}
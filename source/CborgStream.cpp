@@ -0,0 +1,51 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cborg/CborgStream.h"
+
+CborgStream::CborgStream()
+{
+    reset();
+}
+
+void CborgStream::reset()
+{
+    status = CborgTraverse::StatusTruncated;
+    units = 1;
+    total = 0;
+    remaining = 0;
+    stringType = CborBase::TypeString;
+    fill = 0;
+
+    list = CborgStack<Level_t>();
+}
+
+CborgTraverse::Status_t CborgStream::feed(const uint8_t* chunk, std::size_t length, std::size_t* consumed)
+{
+    CborgHandler handler;
+
+    return feed(chunk, length, handler, consumed);
+}
+
+std::size_t CborgStream::getLength() const
+{
+    return total;
+}
+
+std::size_t CborgStream::getDepth() const
+{
+    return list.size();
+}
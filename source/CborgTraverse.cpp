@@ -0,0 +1,373 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cborg/CborgTraverse.h"
+#include "cborg/CborgScan.h"
+
+namespace {
+    // visitor that accepts everything, used for skipping
+    class CborgSkipper
+    {
+    public:
+        bool item(const uint8_t*, const CborgHeader&, std::size_t)
+        {
+            return true;
+        }
+
+        void leave(const uint8_t*, std::size_t)
+        {}
+    };
+}
+
+CborgTraverse::Status_t CborgTraverse::skip(const uint8_t* cbor, std::size_t maxLength, std::size_t* length)
+{
+    CborgSkipper skipper;
+
+    return walk<CborgSkipper, true>(cbor, maxLength, skipper, length);
+}
+
+namespace {
+    // unit count of indefinite containers
+    const std::size_t indefinite = (std::size_t) -1;
+}
+
+CborgTraverse::Status_t CborgTraverse::validate(const uint8_t* cbor, std::size_t maxLength, std::size_t* length)
+{
+    if (cbor == NULL)
+    {
+        return StatusTruncated;
+    }
+
+    typedef struct {
+        std::size_t units;
+        uint8_t chunks;
+        bool pairs;
+        bool pending;
+    } Level_t;
+
+    // remaining units in each open container, for indefinite strings the
+    // type their chunks must have, and for indefinite maps whether a key
+    // is still waiting for its value
+    CborgStack<Level_t> list;
+    CborgHeader head;
+
+    std::size_t progress = 0;
+    std::size_t units = 1;
+    uint8_t chunks = CborBase::TypeUnassigned;
+    bool pairs = false;
+    bool pending = false;
+
+    while (progress < maxLength)
+    {
+        // run of at least two one byte items inside a container
+        if ((list.size() > 0) && (chunks == CborBase::TypeUnassigned) && (progress + 1 < maxLength)
+            && CborgScan::isImmediate(cbor[progress]) && CborgScan::isImmediate(cbor[progress + 1]))
+        {
+            std::size_t limit = maxLength - progress;
+
+            if ((units != indefinite) && (units < limit))
+            {
+                limit = units;
+            }
+
+            std::size_t run = CborgScan::immediates(&cbor[progress], limit);
+
+            progress += run;
+
+            if (units != indefinite)
+            {
+                units -= run;
+            }
+            else if (pairs)
+            {
+                pending = pending != ((run & 1) == 1);
+            }
+        }
+        else
+        {
+            // the complete header, including a tag, must be within bounds,
+            // which only needs checking near the end of the buffer; the
+            // decode itself stays on the straight path
+            if ((maxLength - progress < CborgHeader::MaxLength)
+                && !head.decode(&cbor[progress], maxLength - progress))
+            {
+                return StatusTruncated;
+            }
+
+            head.decode(&cbor[progress]);
+
+            uint8_t type = head.getMajorType();
+            uint8_t simple = head.getMinorType();
+            uint64_t value = head.getValue();
+
+            if ((type == CborBase::TypeSpecial) && (simple == CborBase::TypeIndefinite))
+            {
+                // break is only valid as the end of an indefinite container,
+                // and not between a map key and its value
+                if ((list.size() == 0) || (units != indefinite) || pending
+                    || (head.getTag() != CborBase::TypeUnassigned))
+                {
+                    return StatusMalformed;
+                }
+
+                progress += head.getLength();
+
+                units = list.back().units;
+                chunks = list.back().chunks;
+                pairs = list.back().pairs;
+                pending = list.back().pending;
+                list.pop_back();
+            }
+            else if ((type == CborBase::TypeUnassigned)
+                     || ((chunks != CborBase::TypeUnassigned)
+                         && ((type != chunks) || (simple == CborBase::TypeIndefinite)
+                             || (head.getTag() != CborBase::TypeUnassigned)))
+                     || ((type == CborBase::TypeSpecial) && (simple == CborBase::TypeUnknown) && (value < 32)))
+            {
+                // reserved minor type, invalid chunk, or two byte simple value below 32
+                return StatusMalformed;
+            }
+            else
+            {
+                progress += head.getLength();
+
+                // second tag on the same item, the tagged item follows
+                if (type == CborBase::TypeTag)
+                {
+                    continue;
+                }
+
+                if (units != indefinite)
+                {
+                    units--;
+                }
+                else if (pairs)
+                {
+                    pending = !pending;
+                }
+
+                uint16_t info = head.getInfo();
+
+                if (info & CborgHeader::InfoNested)
+                {
+                    if ((simple == CborBase::TypeIndefinite) || (value > 0))
+                    {
+                        // every element takes at least one byte, so larger
+                        // counts can neither fit in the buffer nor in size_t
+                        if ((simple != CborBase::TypeIndefinite)
+                            && (value > (maxLength - progress) / ((type == CborBase::TypeMap) ? 2 : 1)))
+                        {
+                            return StatusTruncated;
+                        }
+
+                        Level_t level = { units, chunks, pairs, pending };
+
+                        if (!list.push_back(level))
+                        {
+                            return StatusDepthExceeded;
+                        }
+
+                        chunks = CborBase::TypeUnassigned;
+                        pairs = false;
+                        pending = false;
+
+                        if (simple == CborBase::TypeIndefinite)
+                        {
+                            units = indefinite;
+                            pairs = (type == CborBase::TypeMap);
+
+                            if ((type == CborBase::TypeBytes) || (type == CborBase::TypeString))
+                            {
+                                chunks = type;
+                            }
+                        }
+                        else if (type == CborBase::TypeMap)
+                        {
+                            units = 2 * (std::size_t) value;
+                        }
+                        else
+                        {
+                            units = (std::size_t) value;
+                        }
+                    }
+                }
+                else if (info & CborgHeader::InfoPayload)
+                {
+                    if (value > maxLength - progress)
+                    {
+                        return StatusTruncated;
+                    }
+
+                    if ((type == CborBase::TypeString) && !CborgScan::utf8(&cbor[progress], (std::size_t) value))
+                    {
+                        return StatusInvalidUtf8;
+                    }
+
+                    progress += (std::size_t) value;
+                }
+            }
+        }
+
+        // step back up one level for each container that is complete
+        while (units == 0)
+        {
+            if (list.size() > 0)
+            {
+                units = list.back().units;
+                chunks = list.back().chunks;
+                pairs = list.back().pairs;
+                pending = list.back().pending;
+                list.pop_back();
+            }
+            else
+            {
+                *length = progress;
+
+                return StatusOk;
+            }
+        }
+    }
+
+    return StatusTruncated;
+}
+
+std::size_t CborgTraverse::skipUnchecked(const uint8_t* cbor)
+{
+    // validated items never exceed the stack
+    CborgStack<std::size_t> list;
+
+    const uint8_t* pointer = cbor;
+    std::size_t units = 1;
+
+    /*
+        Headers are decoded inline: tags are plain prefixes and only the
+        argument is needed, which avoids the bookkeeping in CborgHeader.
+    */
+    do
+    {
+        // run of one byte items in a definite container, the run can not
+        // extend beyond the remaining units
+        if ((units > 1) && (units != indefinite) && (list.size() > 0)
+            && CborgScan::isImmediate(pointer[0]) && CborgScan::isImmediate(pointer[1]))
+        {
+            std::size_t run = CborgScan::immediates(pointer, units);
+
+            pointer += run;
+            units -= run;
+
+            while ((units == 0) && (list.size() > 0))
+            {
+                units = list.back();
+                list.pop_back();
+            }
+
+            continue;
+        }
+
+        uint8_t initial = *pointer++;
+        uint8_t type = initial >> 5;
+        uint8_t minor = initial & 31;
+        std::size_t value = minor;
+
+        if (value < 24)
+        {
+            // argument in initial byte
+        }
+        else if (value == 24)
+        {
+            value = pointer[0];
+            pointer += 1;
+        }
+        else if (value == 25)
+        {
+            value = ((uint32_t) pointer[0] << 8) | pointer[1];
+            pointer += 2;
+        }
+        else if (value == 26)
+        {
+            value = ((uint32_t) pointer[0] << 24) | ((uint32_t) pointer[1] << 16)
+                  | ((uint32_t) pointer[2] << 8)  |             pointer[3];
+            pointer += 4;
+        }
+        else if (value == 27)
+        {
+            uint64_t high = ((uint32_t) pointer[0] << 24) | ((uint32_t) pointer[1] << 16)
+                          | ((uint32_t) pointer[2] << 8)  |             pointer[3];
+            uint32_t low = ((uint32_t) pointer[4] << 24) | ((uint32_t) pointer[5] << 16)
+                         | ((uint32_t) pointer[6] << 8)  |             pointer[7];
+
+            // validated lengths fit in size_t
+            value = (std::size_t) ((high << 32) | low);
+            pointer += 8;
+        }
+
+        if (type == CborBase::TypeTag)
+        {
+            // the tagged item follows
+        }
+        else if (minor == CborBase::TypeIndefinite)
+        {
+            if (type == CborBase::TypeSpecial)
+            {
+                // break, validated items only have them inside indefinite containers
+                if (list.size() == 0)
+                {
+                    break;
+                }
+
+                units = list.back();
+                list.pop_back();
+            }
+            else
+            {
+                // indefinite container or string
+                if (units != indefinite)
+                {
+                    units--;
+                }
+
+                list.push_back(units);
+                units = indefinite;
+            }
+        }
+        else
+        {
+            if (units != indefinite)
+            {
+                units--;
+            }
+
+            if ((type == CborBase::TypeBytes) || (type == CborBase::TypeString))
+            {
+                pointer += value;
+            }
+            else if (((type == CborBase::TypeArray) || (type == CborBase::TypeMap)) && (value > 0))
+            {
+                list.push_back(units);
+                units = (type == CborBase::TypeMap) ? 2 * value : value;
+            }
+        }
+
+        // step back up one level for each container that is complete
+        while ((units == 0) && (list.size() > 0))
+        {
+            units = list.back();
+            list.pop_back();
+        }
+    } while (units != 0);
+
+    return pointer - cbor;
+}
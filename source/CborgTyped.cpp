@@ -0,0 +1,132 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cborg/CborgTyped.h"
+#include "cborg/CborgScan.h"
+
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define CBORG_TYPED_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+    void swapScalar(const uint8_t* source, uint8_t* destination, std::size_t count, std::size_t width)
+    {
+        for (std::size_t idx = 0; idx < count; idx++)
+        {
+            for (std::size_t byte = 0; byte < width; byte++)
+            {
+                destination[byte] = source[width - 1 - byte];
+            }
+
+            source += width;
+            destination += width;
+        }
+    }
+
+#if defined(CBORG_TYPED_X86)
+    /*
+        SSE2 has no byte shuffle: bytes are swapped within 16-bit lanes with
+        shifts, then the lanes are reversed with word shuffles.
+    */
+    inline __m128i swapSSE2(__m128i value, std::size_t width)
+    {
+        value = _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8));
+
+        if (width == 4)
+        {
+            value = _mm_shufflehi_epi16(_mm_shufflelo_epi16(value, 0xB1), 0xB1);
+        }
+        else if (width == 8)
+        {
+            value = _mm_shufflehi_epi16(_mm_shufflelo_epi16(value, 0x1B), 0x1B);
+        }
+
+        return value;
+    }
+
+    void swapBlocksSSE2(const uint8_t* source, uint8_t* destination, std::size_t length, std::size_t width)
+    {
+        for (std::size_t offset = 0; offset + 16 <= length; offset += 16)
+        {
+            __m128i value = _mm_loadu_si128((const __m128i*) &source[offset]);
+            _mm_storeu_si128((__m128i*) &destination[offset], swapSSE2(value, width));
+        }
+    }
+
+    __attribute__((target("avx2")))
+    void swapBlocksAVX2(const uint8_t* source, uint8_t* destination, std::size_t length, std::size_t width)
+    {
+        // byte order of each element reversed within each 128-bit lane
+        const __m256i swap16 = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                                                1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+        const __m256i swap32 = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                                3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+        const __m256i swap64 = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                                                7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+
+        __m256i mask = (width == 2) ? swap16 : (width == 4) ? swap32 : swap64;
+
+        std::size_t offset = 0;
+
+        for (; offset + 32 <= length; offset += 32)
+        {
+            __m256i value = _mm256_loadu_si256((const __m256i*) &source[offset]);
+            _mm256_storeu_si256((__m256i*) &destination[offset], _mm256_shuffle_epi8(value, mask));
+        }
+
+        // one 16 byte block may remain
+        if (offset + 16 <= length)
+        {
+            __m128i value = _mm_loadu_si128((const __m128i*) &source[offset]);
+            _mm_storeu_si128((__m128i*) &destination[offset],
+                             _mm_shuffle_epi8(value, _mm256_castsi256_si128(mask)));
+        }
+    }
+#endif
+}
+
+void CborgTyped::swap(const uint8_t* source, uint8_t* destination, std::size_t count, std::size_t width)
+{
+    if (width <= 1)
+    {
+        memcpy(destination, source, count * width);
+
+        return;
+    }
+
+    std::size_t done = 0;
+
+#if defined(CBORG_TYPED_X86)
+    // whole 16 byte blocks, elements never straddle a block
+    std::size_t blocks = (count * width) & ~(std::size_t) 15;
+
+    if (CborgScan::getImplementation() == CborgScan::ScanAVX2)
+    {
+        swapBlocksAVX2(source, destination, blocks, width);
+        done = blocks / width;
+    }
+    else if (CborgScan::getImplementation() == CborgScan::ScanSSE2)
+    {
+        swapBlocksSSE2(source, destination, blocks, width);
+        done = blocks / width;
+    }
+#endif
+
+    swapScalar(&source[done * width], &destination[done * width], count - done, width);
+}
@@ -0,0 +1,642 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "cborg/Cbor.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <chrono>
+
+/*
+    Nested payload: map with 32 keys, each value an array of 16 maps
+    holding an integer, a string, a nested array and a simple value.
+*/
+static uint8_t payload[64 * 1024];
+static std::size_t payloadLength = 0;
+
+static void buildPayload()
+{
+    char key[] = "key00";
+
+    Cbore encoder(payload, sizeof(payload));
+
+    encoder.map(32);
+
+    for (std::size_t idx = 0; idx < 32; idx++)
+    {
+        key[3] = '0' + idx / 10;
+        key[4] = '0' + idx % 10;
+
+        encoder.key(key, sizeof(key) - 1)
+               .array(16);
+
+        for (std::size_t item = 0; item < 16; item++)
+        {
+            encoder.map(4)
+                        .key("id").value(item * 1000)
+                        .key("name").value("sensor reading")
+                        .key(7)
+                            .array()
+                                .item(1).item(-200).item(70000).item("abc")
+                            .end()
+                        .key("valid").value(Cbor::TypeTrue);
+        }
+    }
+
+    payloadLength = encoder.getLength();
+}
+
+/*
+    Sensor payload: array of 64 records, each a map with a 512 byte
+    sample block, an array of 256 small readings and a text label.
+*/
+static uint8_t sensors[128 * 1024];
+static std::size_t sensorsLength = 0;
+
+static void encodeSensors(Cbore& encoder)
+{
+    static uint8_t block[512];
+    static char label[200];
+
+    for (std::size_t idx = 0; idx < sizeof(block); idx++)
+    {
+        block[idx] = idx * 7;
+    }
+
+    for (std::size_t idx = 0; idx < sizeof(label); idx++)
+    {
+        label[idx] = 'a' + idx % 26;
+    }
+
+    encoder.array(64);
+
+    for (std::size_t record = 0; record < 64; record++)
+    {
+        encoder.map(3)
+                    .key("samples").value(block, sizeof(block))
+                    .key("label").value(label, sizeof(label))
+                    .key("readings").array(256);
+
+        for (std::size_t idx = 0; idx < 256; idx++)
+        {
+            encoder.item((int32_t) (idx % 48) - 24);
+        }
+    }
+}
+
+static void buildSensors()
+{
+    Cbore encoder(sensors, sizeof(sensors));
+    encodeSensors(encoder);
+
+    sensorsLength = encoder.getLength();
+}
+
+// records of the container benchmark as an arena document
+static CborNode* buildRecords(CborArena& arena)
+{
+    CborNode* records = arena.array(256);
+
+    for (std::size_t record = 0; record < 256; record++)
+    {
+        CborNode* entry = arena.map(2);
+        CborNode* readings = arena.array(8);
+
+        arena.insert(entry, arena.string("id"), arena.integer(record));
+        arena.insert(entry, arena.string("readings"), readings);
+        arena.append(records, entry);
+
+        for (std::size_t idx = 0; idx < 8; idx++)
+        {
+            arena.append(readings, arena.integer((int32_t) idx - 4));
+        }
+    }
+
+    return records;
+}
+
+// stand-in for writing to a file descriptor
+static bool drain(const uint8_t* data, std::size_t length, void* context)
+{
+    *((std::size_t*) context) += length + data[0];
+
+    return true;
+}
+
+/*
+    Run function repeatedly and print the best time per call out of
+    several batches, and the throughput if bytes is set.
+*/
+template <typename F>
+static void measure(const char* name, F function, std::size_t bytes = 0)
+{
+    const std::size_t batches = 10;
+    const std::size_t rounds = 500;
+    volatile uint32_t sink = 0;
+
+    double best = 0;
+
+    for (std::size_t batch = 0; batch < batches; batch++)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        for (std::size_t idx = 0; idx < rounds; idx++)
+        {
+            sink = sink + function();
+        }
+
+        std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+
+        double nanoseconds = std::chrono::duration<double, std::nano>(stop - start).count() / rounds;
+
+        if ((batch == 0) || (nanoseconds < best))
+        {
+            best = nanoseconds;
+        }
+    }
+
+    if (bytes)
+    {
+        printf("%-24s %10.0f ns %8.2f GB/s\r\n", name, best, bytes / best);
+    }
+    else
+    {
+        printf("%-24s %10.0f ns\r\n", name, best);
+    }
+}
+
+int main(void)
+{
+    buildPayload();
+
+    printf("Payload: %u bytes\r\n", (unsigned) payloadLength);
+
+    Cborg top(payload, payloadLength);
+
+    measure("getCBORLength", [&]() {
+        return top.getCBORLength();
+    });
+
+    Cborg validated = Cborg::validate(payload, payloadLength);
+
+    measure("validate", [&]() {
+        return Cborg::validate(payload, payloadLength).getCBORLength();
+    });
+
+    measure("getCBORLength unchecked", [&]() {
+        return validated.getCBORLength();
+    });
+
+    measure("getCBOR", [&]() {
+        const uint8_t* pointer = NULL;
+        uint32_t length = 0;
+        top.getCBOR(&pointer, &length);
+        return length;
+    });
+
+    measure("find(string) last key", [&]() {
+        return top.find("key31").getSize();
+    });
+
+    measure("find(int) nested", [&]() {
+        return top.find("key31").at(15).find(7).getSize();
+    });
+
+    measure("find(int) nested unchecked", [&]() {
+        return validated.find("key31").at(15).find(7).getSize();
+    });
+
+    measure("find() three keys", [&]() {
+        return top.find("key05").getSize() + top.find("key17").getSize() + top.find("key31").getSize();
+    });
+
+    measure("find() multi-key", [&]() {
+        CborgKey keys[] = { "key05", "key17", "key31" };
+        Cborg values[3];
+        top.find(keys, values);
+        return values[0].getSize() + values[1].getSize() + values[2].getSize();
+    });
+
+    CborgPath path("key31[15]{7}");
+
+    measure("path nested", [&]() {
+        return top.find(path).getSize();
+    });
+
+    measure("at() last element", [&]() {
+        return top.find("key00").at(15).getSize();
+    });
+
+    measure("at() all elements", [&]() {
+        Cborg array = top.find("key31");
+        uint32_t sum = 0;
+
+        for (std::size_t idx = 0; idx < array.getSize(); idx++)
+        {
+            sum += array.at(idx).getSize();
+        }
+
+        return sum;
+    });
+
+    measure("elements() all elements", [&]() {
+        uint32_t sum = 0;
+
+        for (Cborg item : top.find("key31").elements())
+        {
+            sum += item.getSize();
+        }
+
+        return sum;
+    });
+
+    // bulk scanning against the scalar path
+    buildSensors();
+
+    printf("Sensors: %u bytes\r\n", (unsigned) sensorsLength);
+
+    const CborgScan::Scan_t implementations[] = { CborgScan::ScanScalar, CborgScan::ScanSSE2, CborgScan::ScanAVX2 };
+    const char* names[] = { "scalar", "sse2", "avx2" };
+
+    for (std::size_t idx = 0; idx < 3; idx++)
+    {
+        if (CborgScan::setImplementation(implementations[idx]) != implementations[idx])
+        {
+            continue;
+        }
+
+        printf("%s:\r\n", names[idx]);
+
+        measure("  skip", [&]() {
+            std::size_t length = 0;
+            CborgTraverse::skip(sensors, sensorsLength, &length);
+            return length;
+        }, sensorsLength);
+
+        measure("  validate", [&]() {
+            std::size_t length = 0;
+            CborgTraverse::validate(sensors, sensorsLength, &length);
+            return length;
+        }, sensorsLength);
+
+        Cborg validated = Cborg::validate(sensors, sensorsLength);
+
+        measure("  skip unchecked", [&]() {
+            return validated.getCBORLength();
+        }, sensorsLength);
+    }
+
+    // floats: shortest encoding and bulk half precision conversion
+    static float readings[1024];
+    static uint8_t floats[8 * 1024];
+    static float decoded[1024];
+
+    for (std::size_t idx = 0; idx < 1024; idx++)
+    {
+        // sensor values quantized to 1/64, with an occasional raw reading
+        readings[idx] = (idx % 16 == 15) ? 20.0f + idx * 0.001f : 20.0f + (idx % 128) / 64.0f;
+    }
+
+    Cbore floatEncoder(floats, sizeof(floats));
+
+    measure("floats as given", [&]() {
+        floatEncoder.reset(false);
+        floatEncoder.setFloatMode(Cbore::FloatAsGiven);
+        floatEncoder.array(readings, 1024);
+        return floatEncoder.getLength();
+    });
+
+    printf("  %u bytes\r\n", (unsigned) floatEncoder.getLength());
+
+    measure("floats shortest", [&]() {
+        floatEncoder.reset(false);
+        floatEncoder.setFloatMode(Cbore::FloatShortest);
+        floatEncoder.array(readings, 1024);
+        return floatEncoder.getLength();
+    });
+
+    printf("  %u bytes\r\n", (unsigned) floatEncoder.getLength());
+
+    Cborg floatDecoder(floats, floatEncoder.getLength());
+
+    const CborgFloat::Convert_t conversions[] = { CborgFloat::ConvertScalar, CborgFloat::ConvertF16C };
+    const char* conversionNames[] = { "scalar", "f16c" };
+
+    static uint16_t halves[4096];
+    static float widened[4096];
+
+    for (std::size_t idx = 0; idx < 2; idx++)
+    {
+        if (CborgFloat::setImplementation(conversions[idx]) != conversions[idx])
+        {
+            continue;
+        }
+
+        printf("%s:\r\n", conversionNames[idx]);
+
+        measure("  getFloats shortest", [&]() {
+            return floatDecoder.getFloats(decoded, 1024);
+        });
+
+        measure("  halfToFloat 4096", [&]() {
+            CborgFloat::halfToFloat(halves, widened, 4096);
+            return (std::size_t) widened[17];
+        }, sizeof(halves));
+    }
+
+    // typed arrays: one bulk copy against an item per sample
+    static int16_t waveform[4096];
+    static uint64_t typedStorage[2 * 1024 + 8];
+    static int16_t samples[4096];
+    // tag and header take five bytes, start at 3 so the payload is aligned
+    uint8_t* typed = ((uint8_t*) typedStorage) + 3;
+
+    for (std::size_t idx = 0; idx < 4096; idx++)
+    {
+        waveform[idx] = (idx % 256) * 97 - 12000;
+    }
+
+    Cbore typedEncoder(typed, sizeof(typedStorage) - 3);
+
+    measure("typedArray 4096", [&]() {
+        typedEncoder.reset(false);
+        typedEncoder.typedArray(waveform, 4096);
+        return typedEncoder.getLength();
+    }, sizeof(waveform));
+
+    Cborg typedDecoder(typed, typedEncoder.getLength());
+
+    measure("getTypedArray in place", [&]() {
+        return typedDecoder.getTypedArray<int16_t>().size();
+    }, sizeof(waveform));
+
+    // same array in the other byte order
+    static uint64_t foreignStorage[2 * 1024 + 8];
+    uint8_t* foreign = ((uint8_t*) foreignStorage) + 3;
+
+    memcpy(foreign, typed, typedEncoder.getLength());
+    foreign[1] ^= CborgTyped::TagLittleEndian;
+
+    Cborg foreignDecoder(foreign, typedEncoder.getLength());
+
+    for (std::size_t idx = 0; idx < 3; idx++)
+    {
+        if (CborgScan::setImplementation(implementations[idx]) != implementations[idx])
+        {
+            continue;
+        }
+
+        printf("%s:\r\n", names[idx]);
+
+        measure("  getTypedArray swapped", [&]() {
+            return foreignDecoder.getTypedArray(samples, 4096).size();
+        }, sizeof(waveform));
+    }
+
+    static uint8_t items[16 * 1024];
+    Cbore itemEncoder(items, sizeof(items));
+
+    measure("item() 4096", [&]() {
+        itemEncoder.reset(false);
+        itemEncoder.array(4096);
+
+        for (std::size_t idx = 0; idx < 4096; idx++)
+        {
+            itemEncoder.item(waveform[idx]);
+        }
+
+        return itemEncoder.getLength();
+    }, sizeof(waveform));
+
+    printf("  %u bytes against %u\r\n", (unsigned) itemEncoder.getLength(), (unsigned) typedEncoder.getLength());
+
+    Cborg itemDecoder(items, itemEncoder.getLength());
+
+    measure("elements() 4096", [&]() {
+        std::size_t idx = 0;
+
+        for (Cborg item : itemDecoder.elements())
+        {
+            int64_t value = 0;
+            item.getInteger(&value);
+            samples[idx++] = value;
+        }
+
+        return idx;
+    }, sizeof(waveform));
+
+    // output sinks against a fixed buffer
+    static uint8_t encoded[128 * 1024];
+    std::vector<uint8_t> grown;
+    static uint8_t window[4096];
+    std::size_t drained = 0;
+
+    measure("encode sensors fixed", [&]() {
+        Cbore encoder(encoded, sizeof(encoded));
+        encodeSensors(encoder);
+        return encoder.getLength();
+    }, sensorsLength);
+
+    measure("encode sensors vector", [&]() {
+        CboreVectorSink sink(grown);
+        Cbore encoder(sink);
+        encodeSensors(encoder);
+        encoder.flush();
+        return encoder.getLength();
+    }, sensorsLength);
+
+    measure("encode sensors callback", [&]() {
+        CboreCallbackSink sink(window, sizeof(window), drain, &drained);
+        Cbore encoder(sink);
+        encodeSensors(encoder);
+        encoder.flush();
+        return encoder.getLength();
+    }, sensorsLength);
+
+    measure("measure sensors", [&]() {
+        CboreCountSink sink;
+        Cbore encoder(sink);
+        encodeSensors(encoder);
+        return encoder.getLength();
+    }, sensorsLength);
+
+    // forwarding a subdocument, encoded again against spliced
+    Cborg incoming(sensors, sensorsLength);
+
+    measure("forward sensors encoded", [&]() {
+        Cbore encoder(encoded, sizeof(encoded));
+        encoder.map(2).key("via").value("proxy").key("payload");
+        encodeSensors(encoder);
+        return encoder.getLength();
+    }, sensorsLength);
+
+    measure("forward sensors raw", [&]() {
+        Cbore encoder(encoded, sizeof(encoded));
+        encoder.map(2).key("via").value("proxy").key("payload").raw(incoming);
+        return encoder.getLength();
+    }, sensorsLength);
+
+    // large payloads copied against referenced
+    static uint8_t image[1024 * 1024];
+    static uint8_t headers[256];
+    std::vector<uint8_t> copied;
+
+    measure("image 1 MiB copied", [&]() {
+        CboreVectorSink sink(copied);
+        Cbore encoder(sink);
+        encoder.map(2).key("version").value(3).key("image").value(image, sizeof(image));
+        encoder.flush();
+        return encoder.getLength();
+    }, sizeof(image));
+
+    measure("image 1 MiB gathered", [&]() {
+        CboreGatherSink sink(headers, sizeof(headers), 1024);
+        Cbore encoder(sink);
+        encoder.map(2).key("version").value(3).key("image").value(image, sizeof(image));
+        encoder.flush();
+        return encoder.getLength() + sink.getCount();
+    }, sizeof(image));
+
+    // telemetry message through the fluent chain against a stencil
+    static uint8_t telemetry[128];
+    static uint8_t storage[128];
+    std::size_t sequence, temperature, humidity, energy;
+    uint32_t counter = 0;
+
+    Cbore stencilEncoder(storage, sizeof(storage));
+    stencilEncoder.map(4)
+                    .key("device").value("sensor-17")
+                    .key("seq").slot(Cbore::SlotInteger32, &sequence)
+                    .key("values").array(2)
+                        .slot(Cbore::SlotFloat, &temperature)
+                        .slot(Cbore::SlotFloat, &humidity)
+                    .key("energy").slot(Cbore::SlotDouble, &energy);
+
+    CboreStencil stencil(storage, stencilEncoder.getLength());
+
+    measure("telemetry fluent", [&]() {
+        counter++;
+
+        Cbore encoder(telemetry, sizeof(telemetry));
+        encoder.map(4)
+                    .key("device").value("sensor-17")
+                    .key("seq").value(counter)
+                    .key("values").array(2)
+                        .item(20.5f + counter)
+                        .item(0.25f * counter)
+                    .key("energy").value(1.5 * counter);
+
+        return encoder.getLength();
+    }, stencil.getLength());
+
+    measure("telemetry stencil", [&]() {
+        counter++;
+
+        std::size_t length = stencil.copy(telemetry, sizeof(telemetry));
+        CboreStencil::setUnsigned(telemetry, sequence, counter);
+        CboreStencil::setFloat(telemetry, temperature, 20.5f + counter);
+        CboreStencil::setFloat(telemetry, humidity, 0.25f * counter);
+        CboreStencil::setDouble(telemetry, energy, 1.5 * counter);
+
+        return length;
+    }, stencil.getLength());
+
+    static constexpr auto device = CboreConstant::encode(
+        CboreConstant::join(CboreConstant::string("device"), CboreConstant::string("sensor-17")));
+
+    measure("telemetry constant", [&]() {
+        counter++;
+
+        Cbore encoder(telemetry, sizeof(telemetry));
+        encoder.map(4)
+                    .constant(device, 2)
+                    .key("seq").value(counter)
+                    .key("values").array(2)
+                        .item(20.5f + counter)
+                        .item(0.25f * counter)
+                    .key("energy").value(1.5 * counter);
+
+        return encoder.getLength();
+    }, stencil.getLength());
+
+    // document built in an arena, then encoded
+    static uint8_t arenaStorage[128 * 1024];
+    static uint8_t arenaOutput[64 * 1024];
+    CborArena arena(arenaStorage, sizeof(arenaStorage));
+    CborNode* records = NULL;
+
+    measure("arena build records", [&]() {
+        arena.reset();
+        records = buildRecords(arena);
+        return arena.getUsed();
+    });
+
+    measure("arena encode records", [&]() {
+        return records->writeCBOR(arenaOutput, sizeof(arenaOutput));
+    });
+
+    // containers without counts: indefinite, patched in place and compacted
+    static uint8_t modes[64 * 1024];
+    const Cbore::ContainerMode_t containerModes[] = { Cbore::ContainerIndefinite, Cbore::ContainerPatch, Cbore::ContainerCompact };
+    const char* modeNames[] = { "indefinite", "patch", "compact" };
+
+    for (std::size_t mode = 0; mode < 3; mode++)
+    {
+        printf("%s:\r\n", modeNames[mode]);
+
+        Cbore encoder(modes, sizeof(modes));
+
+        measure("  encode records", [&]() {
+            encoder.reset(false);
+            encoder.setContainerMode(containerModes[mode]);
+            encoder.array();
+
+            for (std::size_t record = 0; record < 256; record++)
+            {
+                encoder.map()
+                            .key("id").value(record)
+                            .key("readings").array();
+
+                for (std::size_t idx = 0; idx < 8; idx++)
+                {
+                    encoder.item((int32_t) idx - 4);
+                }
+
+                encoder.end().end();
+            }
+
+            encoder.end();
+
+            return encoder.getLength();
+        });
+
+        printf("  %u bytes\r\n", (unsigned) encoder.getLength());
+
+        Cborg decoder(modes, encoder.getLength());
+
+        measure("  getCBORLength", [&]() {
+            return decoder.getCBORLength();
+        });
+
+        measure("  at() last record", [&]() {
+            return decoder.at(255).find("readings").getSize();
+        });
+    }
+
+    return 0;
+}
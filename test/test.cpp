@@ -16,9 +16,40 @@
 
 
 #include "cborg/Cbor.h"
+#include "cborg/CborgStack.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string>
+#include <vector>
+#include <new>
+#include <limits>
+#include <cinttypes>
+#include <math.h>
+
+/*
+    Count heap allocations made through operator new.
+*/
+static std::size_t allocations = 0;
+
+void* operator new(std::size_t size)
+{
+    allocations++;
+
+    void* pointer = malloc(size);
+
+    if (pointer == NULL)
+    {
+        throw std::bad_alloc();
+    }
+
+    return pointer;
+}
+
+void operator delete(void* pointer) noexcept
+{
+    free(pointer);
+}
 
 /*
     https://geraintluff.github.io/cbor-debug/
@@ -217,6 +248,29 @@ void test4()
         }
     }
 
+    // payloads past the end of the buffer and indefinite strings
+    {
+        uint8_t string[] = { 0x63, 0x61, 0x62, 0x63 };
+        uint8_t bytes[] = { 0x43, 0x01, 0x02, 0x03 };
+        uint8_t chunked[] = { 0x7F, 0x61, 0x61, 0xFF };
+
+        const char* pointer = NULL;
+        const uint8_t* payload = NULL;
+        uint64_t length = 0;
+        std::string copy;
+
+        printf("Bounded string: %d %d %d\r\n",
+               Cborg(string, sizeof(string)).getString(&pointer, &length),
+               Cborg(string, 3).getString(&pointer, &length),
+               Cborg(string, 3).getString(copy));
+        printf("Bounded bytes: %d %d\r\n",
+               Cborg(bytes, sizeof(bytes)).getBytes(&payload, &length),
+               Cborg(bytes, 3).getBytes(&payload, &length));
+        printf("Indefinite string: %d %d\r\n",
+               Cborg(chunked, sizeof(chunked)).getString(&pointer, &length),
+               Cborg(chunked, sizeof(chunked)).getString(copy));
+    }
+
     printf("\r\n===============================================================================\r\n");
 }
 
@@ -346,21 +400,2121 @@ void test8()
     encoder.print();
 }
 
-/*****************************************************************************/
-/* App start                                                                 */
-/*****************************************************************************/
-void app_start(int, char *[])
+/*
+    Test 9: lookups through a structural index.
+*/
+void test9()
 {
-    test1();
-    test2();
-    test3();
-    test4();
+    printf("Test 9: Indexed lookups:\r\n");
 
-    test5();
+    CborgIndex index;
 
-    test6();
-    test7();
-    test8();
+    if (!index.build(buffer, sizeof(buffer)))
+    {
+        printf("error\r\n");
+        return;
+    }
+
+    printf("Entries: %u\r\n", (unsigned) index.getEntries());
+
+    // loop through all intents and print endpoints
+    CborgIndexed intents = index.root().find("body").find("intents");
+
+    for (std::size_t idx = 0; idx < intents.getSize(); idx++)
+    {
+        intents.at(idx).find("endpoint").print();
+    }
+
+    // compare raw encoding with the non-indexed decoder
+    Cborg plain = Cborg(buffer, sizeof(buffer)).find("body").find("intents").at(2);
+    CborgIndexed indexed = intents.at(2);
+
+    const uint8_t* plainPointer = NULL;
+    const uint8_t* indexedPointer = NULL;
+    uint32_t plainLength = 0;
+    uint32_t indexedLength = 0;
+
+    plain.getCBOR(&plainPointer, &plainLength);
+    indexed.getCBOR(&indexedPointer, &indexedLength);
+
+    printf("Same encoding: %s\r\n", ((plainPointer == indexedPointer) && (plainLength == indexedLength)) ? "yes" : "no");
+
+    // items with two tags start at the first one, 229(8("id")) and [55799(8("id")), 1]
+    uint8_t twoTags[] = { 0xD8, 0xE5, 0xD8, 0x08, 0x62, 0x69, 0x64 };
+    uint8_t selfDescribed[] = { 0x82, 0xD9, 0xD9, 0xF7, 0xC8, 0x62, 0x69, 0x64, 0x01 };
+
+    CborgIndex tagIndex;
+    tagIndex.build(twoTags, sizeof(twoTags));
+
+    printf("Two tags: index: %u, plain: %u, tag: %" PRIu32 "\r\n", (unsigned) tagIndex.root().getCBORLength(),
+           (unsigned) Cborg(twoTags, sizeof(twoTags)).getCBORLength(), tagIndex.root().getTag());
+
+    tagIndex.build(selfDescribed, sizeof(selfDescribed));
+    Cborg first = Cborg(selfDescribed, sizeof(selfDescribed)).at(0);
+
+    tagIndex.root().at(0).getCBOR(&indexedPointer, &indexedLength);
+    first.getCBOR(&plainPointer, &plainLength);
+
+    printf("Self-described: same encoding: %s, length: %" PRIu32 ", tag: %" PRIu32 ", last: %u\r\n",
+           ((plainPointer == indexedPointer) && (plainLength == indexedLength)) ? "yes" : "no", indexedLength,
+           tagIndex.root().at(0).getTag(), (unsigned) tagIndex.root().at(1).getCBORLength());
+
+    // integer and string keys, {-2: 1, 7: 2, "key": 3}
+    uint8_t keys[] = { 0xA3, 0x21, 0x01, 0x07, 0x02, 0x63, 0x6B, 0x65, 0x79, 0x03 };
+    CborgIndex keyIndex;
+    keyIndex.build(keys, sizeof(keys));
+
+    printf("Keys: -2: %" PRIu8 ", 7: %" PRIu8 ", key: %" PRIu8 ", missing: %u\r\n",
+           keyIndex.root().find(-2).getMinorType(), keyIndex.root().find(7).getMinorType(),
+           keyIndex.root().find("key").getMinorType(),
+           (unsigned) (keyIndex.root().find(2).getCBORLength() + keyIndex.root().find("ke").getCBORLength()));
+
+    // offsets are 32-bit, larger buffers are rejected before they are read
+    printf("Oversized buffer: %s\r\n",
+           tagIndex.build(twoTags, (std::size_t) std::numeric_limits<uint32_t>::max() + 1) ? "accepted" : "rejected");
+
+    printf("\r\n===============================================================================\r\n");
+}
+
+/*
+    Test 10: decoding does not allocate and rejects excessive nesting.
+*/
+void test10()
+{
+    printf("Test 10: Allocation-free decoding:\r\n");
+
+    std::size_t before = allocations;
+
+    Cborg top(buffer, sizeof(buffer));
+    uint32_t length = top.getCBORLength();
+
+    Cborg intents = top.find("body").find("intents");
+
+    for (std::size_t idx = 0; idx < intents.getSize(); idx++)
+    {
+        const uint8_t* pointer = NULL;
+        uint32_t endpointLength = 0;
+
+        intents.at(idx).find("endpoint").getCBOR(&pointer, &endpointLength);
+    }
+
+    printf("Length: %" PRIu32 ", allocations: %u\r\n", length, (unsigned) (allocations - before));
+
+    // arrays nested twice as deep as supported
+    uint8_t nested[2 * CBORG_MAX_DEPTH + 1];
+
+    for (std::size_t idx = 0; idx < sizeof(nested) - 1; idx++)
+    {
+        nested[idx] = 0x81;
+    }
+    nested[sizeof(nested) - 1] = 0x00;
+
+    Cborg deep(nested, sizeof(nested));
+    printf("Depth exceeded: %s\r\n", (deep.getCBORLength() == 0) ? "yes" : "no");
+
+    printf("\r\n===============================================================================\r\n");
+}
+
+/*
+    Test 11: look up several keys in one pass.
+*/
+void test11()
+{
+    printf("Test 11: Multi-key lookup:\r\n");
+
+    Cborg top(buffer, sizeof(buffer));
+
+    CborgKey keys[] = { "status", "id", "body", 7 };
+    Cborg values[4];
+
+    std::size_t found = top.find(keys, values);
+
+    printf("Found: %u\r\n", (unsigned) found);
+
+    for (std::size_t idx = 0; idx < 4; idx++)
+    {
+        values[idx].print();
+    }
+
+    // same values as separate lookups
+    printf("Same as find: %s\r\n", (values[1].getCBORLength() == top.find("id").getCBORLength()) ? "yes" : "no");
+
+    printf("\r\n===============================================================================\r\n");
+}
+
+/*
+    Test 12: compiled path expressions.
+*/
+void test12()
+{
+    printf("Test 12: Path expressions:\r\n");
+
+    Cborg top(buffer, sizeof(buffer));
+
+    CborgPath endpoint("body.intents[2].endpoint");
+
+    printf("Steps: %u\r\n", (unsigned) endpoint.getSteps());
+    endpoint.evaluate(buffer, sizeof(buffer)).print();
+
+    // same item as the equivalent find/at chain
+    Cborg chain = top.find("body").find("intents").at(2).find("endpoint");
+    printf("Same as chain: %s\r\n", (top.find(endpoint).getCBORLength() == chain.getCBORLength()) ? "yes" : "no");
+
+    // integer keys and missing items
+    uint8_t integers[] = { 0xA1, 0x07, 0x82, 0x18, 0x2A, 0x20 };
+
+    CborgPath first("{7}[0]");
+    CborgPath second("{7}[1]");
+    CborgPath missing("{7}[2]");
+
+    first.evaluate(integers, sizeof(integers)).print();
+    second.evaluate(integers, sizeof(integers)).print();
+    printf("Missing: %s\r\n", (missing.evaluate(integers, sizeof(integers)).getCBORLength() == 0) ? "yes" : "no");
+
+    // lookups on validated handles stay validated, also through a path
+    Cborg checked = Cborg::validate(integers, sizeof(integers));
+    printf("Validated: %s, missing: %s\r\n", checked.find(second).isValidated() ? "yes" : "no",
+           (checked.find(missing).getCBORLength() == 0) ? "yes" : "no");
+
+    // malformed paths
+    const char* invalid[] = { "", ".body", "body..intents", "[2", "{x}", "[-1]", "body[1]x" };
+
+    for (std::size_t idx = 0; idx < sizeof(invalid) / sizeof(invalid[0]); idx++)
+    {
+        printf("\"%s\": %s\r\n", invalid[idx], CborgPath(invalid[idx]).isValid() ? "valid" : "invalid");
+    }
+
+    printf("\r\n===============================================================================\r\n");
+}
+
+/*
+    Test 13: iterate over arrays and maps.
+*/
+void test13()
+{
+    printf("Test 13: Iterators:\r\n");
+
+    Cborg top(buffer, sizeof(buffer));
+
+    for (CborgPair pair : top.find("body").pairs())
+    {
+        pair.key.print();
+    }
+
+    for (Cborg intent : top.find("body").find("intents").elements())
+    {
+        intent.find("id").print();
+    }
+
+    // indefinite array [1, [2, 3], 4]
+    uint8_t indefinite[] = { 0x9F, 0x01, 0x82, 0x02, 0x03, 0x04, 0xFF };
+
+    for (Cborg item : Cborg(indefinite, sizeof(indefinite)).elements())
+    {
+        printf("Item: %u bytes\r\n", (unsigned) item.getCBORLength());
+    }
+
+    // large array is walked in a single pass
+    static uint8_t large[4 * 10000];
+    Cbore encoder(large, sizeof(large));
+
+    encoder.array(10000);
+
+    for (std::size_t idx = 0; idx < 10000; idx++)
+    {
+        encoder.item((uint32_t) idx);
+    }
+
+    std::size_t count = 0;
+    uint32_t sum = 0;
+
+    for (Cborg item : Cborg(large, encoder.getLength()).elements())
+    {
+        uint32_t value = 0;
+        item.getUnsigned(&value);
+
+        sum += value;
+        count++;
+    }
+
+    printf("Count: %u, sum: %" PRIu32 "\r\n", (unsigned) count, sum);
+
+    printf("\r\n===============================================================================\r\n");
+}
+
+/*
+    Test 14: pull parser.
+*/
+void test14()
+{
+    printf("Test 14: Cursor:\r\n");
+
+    // consume the top level map front to back
+    CborgCursor cursor(buffer, sizeof(buffer));
+
+    printf("Tag: %" PRIu32 ", size: %" PRIu32 "\r\n", cursor.getTag(), cursor.getSize());
+
+    cursor.enter();
+
+    while (!cursor.isEnd())
+    {
+        std::string key;
+        cursor.getString(key);
+        cursor.skip();
+
+        uint32_t value = 0;
+
+        if (cursor.getUnsigned(&value))
+        {
+            printf("%s: %" PRIu32 "\r\n", key.c_str(), value);
+            cursor.skip();
+        }
+        else if (key == "body")
+        {
+            // read the first intent and leave the rest of the body unread
+            cursor.enter();
+            cursor.skip();
+            cursor.skip();
+            cursor.skip();
+            cursor.enter();
+
+            printf("First intent: %" PRIu32 " pairs, depth: %u\r\n", cursor.getSize(), (unsigned) cursor.getDepth());
+
+            cursor.leave();
+            cursor.leave();
+        }
+        else
+        {
+            cursor.skip();
+        }
+    }
+
+    cursor.leave();
+    printf("Offset: %u, status: %u\r\n", (unsigned) cursor.getOffset(), (unsigned) cursor.getStatus());
+
+    // count all items in document order, [1, [_ "ab", "c"], {2: h''}]
+    uint8_t mixed[] = { 0x83, 0x01, 0x7F, 0x62, 0x61, 0x62, 0x61, 0x63, 0xFF, 0xA1, 0x02, 0x40 };
+    CborgCursor tokens(mixed, sizeof(mixed));
+
+    std::size_t items = 0;
+
+    do
+    {
+        if (!tokens.isEnd())
+        {
+            printf("%u:%u ", (unsigned) tokens.getDepth(), tokens.getType());
+            items++;
+        }
+    } while (tokens.next());
+
+    printf("\r\nItems: %u, status: %u\r\n", (unsigned) items, (unsigned) tokens.getStatus());
+
+    // truncated buffer
+    CborgCursor truncated(mixed, 5);
+
+    while (truncated.next())
+    {}
+
+    printf("Truncated: %s\r\n", (truncated.getStatus() == CborgTraverse::StatusTruncated) ? "yes" : "no");
+
+    printf("\r\n===============================================================================\r\n");
+}
+
+/*
+    Test 15: event driven decoding.
+*/
+class EventPrinter : public CborgHandler
+{
+public:
+    bool beginMap(uint32_t size) { printf("{%" PRIu32 " ", size); return true; }
+    void endMap() { printf("} "); }
+
+    bool beginArray(uint32_t size) { printf("[%" PRIu32 " ", size); return true; }
+    void endArray() { printf("] "); }
+
+    bool key() { printf("key:"); return true; }
+
+    bool integer(int64_t value) { printf("%" PRId64 " ", value); return true; }
+    bool largeInteger(bool negative, uint64_t value) { printf("%s%" PRIu64 " ", negative ? "-1-" : "", value); return true; }
+
+    bool beginString() { printf("(_ "); return true; }
+    bool string(const char* pointer, uint32_t length) { printf("\"%.*s\" ", (int) length, pointer); return true; }
+    void endString() { printf(") "); }
+
+    bool bytes(const uint8_t*, uint32_t length) { printf("h%" PRIu32 " ", length); return true; }
+
+    bool tag(uint32_t value) { printf("%" PRIu32 "(", value); return true; }
+    bool simple(uint8_t value) { printf("simple(%u) ", value); return true; }
+    bool floating(double value) { printf("%.5f ", value); return true; }
+};
+
+class StringCounter : public CborgHandler
+{
+public:
+    StringCounter()
+        :   count(0),
+            total(0)
+    {}
+
+    bool string(const char*, uint32_t length)
+    {
+        count++;
+        total += length;
+
+        return true;
+    }
+
+    uint32_t count;
+    uint32_t total;
+};
+
+void test15()
+{
+    printf("Test 15: Event decoder:\r\n");
+
+    // [1.5, 3.14159, 3.141592653589793, true, null, h'01', {_ "a": -5}, 32("x"), (_ "ab", "c")]
+    uint8_t events[] = { 0x89, 0xF9, 0x3E, 0x00, 0xFA, 0x40, 0x49, 0x0F, 0xD0,
+                         0xFB, 0x40, 0x09, 0x21, 0xFB, 0x54, 0x44, 0x2D, 0x18,
+                         0xF5, 0xF6, 0x41, 0x01, 0xBF, 0x61, 0x61, 0x24, 0xFF,
+                         0xD8, 0x20, 0x61, 0x78, 0x7F, 0x62, 0x61, 0x62, 0x61,
+                         0x63, 0xFF };
+
+    EventPrinter printer;
+    std::size_t length = 0;
+
+    CborgTraverse::Status_t status = CborgSax::decode(events, sizeof(events), printer, &length);
+    printf("\r\nStatus: %u, length: %u\r\n", (unsigned) status, (unsigned) length);
+
+    // aggregate without creating Cborg objects
+    StringCounter counter;
+    CborgSax::decode(buffer, sizeof(buffer), counter);
+
+    printf("Strings: %" PRIu32 ", characters: %" PRIu32 "\r\n", counter.count, counter.total);
+
+    // string running past the end of the buffer
+    status = CborgSax::decode(events, 21, printer);
+    printf("\r\nTruncated: %s\r\n", (status == CborgTraverse::StatusTruncated) ? "yes" : "no");
+
+    // string header cut off in the middle of its four byte argument
+    uint8_t cut[] = { 0x82, 0x01, 0x5A, 0xB6, 0x00, 0x00, 0x00 };
+
+    status = CborgSax::decode(cut, 4, printer);
+    printf("\r\nCut header: %s\r\n", (status == CborgTraverse::StatusTruncated) ? "yes" : "no");
+
+    printf("\r\n===============================================================================\r\n");
+}
+
+/*
+    Test 16: incremental decoding.
+*/
+void test16()
+{
+    printf("Test 16: Incremental decoder:\r\n");
+
+    // feed the buffer in chunks of every size from 1 to 7 bytes
+    for (std::size_t size = 1; size <= 7; size++)
+    {
+        CborgStream stream;
+        StringCounter counter;
+
+        CborgTraverse::Status_t status = CborgTraverse::StatusTruncated;
+        std::size_t position = 0;
+        std::size_t chunks = 0;
+
+        while ((status == CborgTraverse::StatusTruncated) && (position < sizeof(buffer)))
+        {
+            std::size_t length = sizeof(buffer) - position;
+            std::size_t consumed = 0;
+
+            if (length > size)
+            {
+                length = size;
+            }
+
+            status = stream.feed(&buffer[position], length, counter, &consumed);
+
+            position += consumed;
+            chunks++;
+        }
+
+        printf("Chunk %u: status %u, length %u, chunks %u, characters %" PRIu32 "\r\n",
+               (unsigned) size, (unsigned) status, (unsigned) stream.getLength(),
+               (unsigned) chunks, counter.total);
+    }
+
+    // two items in one chunk, [1, "ab"] 7
+    uint8_t items[] = { 0x82, 0x01, 0x62, 0x61, 0x62, 0x07 };
+
+    CborgStream stream;
+    EventPrinter printer;
+    std::size_t consumed = 0;
+
+    CborgTraverse::Status_t status = stream.feed(items, sizeof(items), printer, &consumed);
+    printf("\r\nStatus: %u, consumed: %u\r\n", (unsigned) status, (unsigned) consumed);
+
+    stream.reset();
+    status = stream.feed(&items[consumed], sizeof(items) - consumed, printer, &consumed);
+    printf("\r\nStatus: %u, consumed: %u\r\n", (unsigned) status, (unsigned) consumed);
+
+    // break outside an indefinite container
+    uint8_t broken[] = { 0x82, 0x01, 0xFF };
+
+    stream.reset();
+    status = stream.feed(broken, sizeof(broken), &consumed);
+    printf("Malformed: %s\r\n", (status == CborgTraverse::StatusMalformed) ? "yes" : "no");
+
+    printf("\r\n===============================================================================\r\n");
+}
+
+/*
+    Test 17: decoding from non-contiguous buffers.
+*/
+void test17()
+{
+    printf("Test 17: Scatter/gather decoding:\r\n");
+
+    // split buffer into 16 byte segments, with an empty segment at the start
+    const std::size_t size = 16;
+
+    CborgSegment segments[2 + sizeof(buffer) / size];
+    std::size_t count = 0;
+
+    segments[count].data = buffer;
+    segments[count].length = 0;
+    count++;
+
+    for (std::size_t position = 0; position < sizeof(buffer); position += size)
+    {
+        segments[count].data = &buffer[position];
+        segments[count].length = (sizeof(buffer) - position < size) ? sizeof(buffer) - position : size;
+        count++;
+    }
+
+    CborgScatter top(segments, count);
+
+    printf("Length: %" PRIu32 ", tag: %" PRIu32 "\r\n", (uint32_t) top.getCBORLength(), top.getTag());
+
+    uint32_t id = 0;
+    top.find("id").getUnsigned(&id);
+    printf("id: %" PRIu32 "\r\n", id);
+
+    CborgScatter intents = top.find("body").find("intents");
+
+    for (std::size_t idx = 0; idx < intents.getSize(); idx++)
+    {
+        CborgScatter name = intents.at(idx).find("id");
+
+        std::string copy;
+        name.getString(copy);
+
+        const char* pointer = NULL;
+        uint32_t length = 0;
+        bool inPlace = name.getString(&pointer, &length);
+
+        printf("%s, in place: %s\r\n", copy.c_str(), inPlace ? "yes" : "no");
+    }
+
+    // small items within one segment are available as Cborg objects
+    Cborg status = top.find("status").getCborg();
+    printf("Status: %" PRIu32 " bytes\r\n", (uint32_t) status.getCBORLength());
+
+    // {-2: 1, "long key": 2} with the string key split in the middle
+    uint8_t keys[] = { 0xA2, 0x21, 0x01, 0x68, 0x6C, 0x6F, 0x6E, 0x67, 0x20, 0x6B, 0x65, 0x79, 0x02 };
+    CborgSegment halves[] = { { keys, 6 }, { &keys[6], sizeof(keys) - 6 } };
+    CborgScatter split(halves, 2);
+
+    uint32_t negative = 0;
+    uint32_t straddling = 0;
+
+    split.find(-2).getUnsigned(&negative);
+    split.find("long key").getUnsigned(&straddling);
+
+    printf("Keys: -2: %" PRIu32 ", long key: %" PRIu32 ", missing: %u\r\n", negative, straddling,
+           (unsigned) (split.find(2).getCBORLength() + split.find("long").getCBORLength()));
+
+    printf("\r\n===============================================================================\r\n");
+}
+
+/*
+    Test 18: validation and unchecked decoding.
+*/
+void test18()
+{
+    printf("Test 18: Validation:\r\n");
+
+    Cborg top = Cborg::validate(buffer, sizeof(buffer));
+
+    printf("Validated: %s, length: %" PRIu32 "\r\n", top.isValidated() ? "yes" : "no", (uint32_t) top.getCBORLength());
+
+    // lookups on a validated handle return validated handles
+    Cborg endpoint = top.find("body").find("intents").at(4).find("endpoint");
+    printf("Child validated: %s\r\n", endpoint.isValidated() ? "yes" : "no");
+    endpoint.print();
+
+    std::size_t count = 0;
+
+    for (Cborg intent : top.find("body").find("intents").elements())
+    {
+        count += intent.isValidated() ? 1 : 0;
+    }
+
+    printf("Validated intents: %u\r\n", (unsigned) count);
+
+    // each case is rejected with the given status
+    const struct {
+        const char* name;
+        uint8_t cbor[8];
+        std::size_t length;
+    } cases[] = {
+        { "truncated header",   { 0x19, 0x01 }, 2 },
+        { "truncated string",   { 0x63, 0x61, 0x62 }, 3 },
+        { "reserved minor",     { 0x1C }, 1 },
+        { "break outside",      { 0x81, 0xFF }, 2 },
+        { "tagged break",       { 0x9F, 0xC1, 0xFF }, 3 },
+        { "nested chunk",       { 0x5F, 0x5F, 0xFF, 0xFF }, 4 },
+        { "mixed chunk",        { 0x7F, 0x41, 0x00, 0xFF }, 4 },
+        { "simple below 32",    { 0xF8, 0x10 }, 2 },
+        { "huge array",         { 0x9B, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, }, 8 },
+        { "key without value",  { 0xBF, 0x01, 0xFF }, 3 },
+        { "odd map",            { 0xBF, 0x01, 0x02, 0x03, 0xFF }, 5 },
+        { "nested odd map",     { 0x81, 0xBF, 0x61, 0x61, 0x80, 0x01, 0xFF }, 7 },
+    };
+
+    for (std::size_t idx = 0; idx < sizeof(cases) / sizeof(cases[0]); idx++)
+    {
+        std::size_t length = 0;
+        CborgTraverse::Status_t status = CborgTraverse::validate(cases[idx].cbor, cases[idx].length, &length);
+
+        printf("%s: %u\r\n", cases[idx].name, (unsigned) status);
+    }
+
+    // two tags on one item count as one item, [6(7("a")), 1]
+    uint8_t tagged[] = { 0x82, 0xC6, 0xC7, 0x61, 0x61, 0x01 };
+
+    std::size_t length = 0;
+    CborgTraverse::Status_t status = CborgTraverse::validate(tagged, sizeof(tagged), &length);
+    printf("Tags: %u, length: %u\r\n", (unsigned) status, (unsigned) length);
+
+    // complete pairs in an indefinite map pass, {_ 1: 2, "a": []}
+    uint8_t pairs[] = { 0xBF, 0x01, 0x02, 0x61, 0x61, 0x80, 0xFF };
+
+    status = CborgTraverse::validate(pairs, sizeof(pairs), &length);
+    printf("Pairs: %u, length: %u\r\n", (unsigned) status, (unsigned) length);
+
+    // a key without value is never a validated handle
+    uint8_t odd[] = { 0xBF, 0x01, 0xFF };
+
+    Cborg oddMap = Cborg::validate(odd, sizeof(odd));
+    printf("Odd map validated: %s\r\n", oddMap.isValidated() ? "yes" : "no");
+
+    // unchecked skipping stops at a stray break instead of popping an empty stack
+    uint8_t stray[] = { 0xFF };
+    printf("Stray break: %u\r\n", (unsigned) CborgTraverse::skipUnchecked(stray));
+
+    // heads cut inside their argument, copied to exact-size allocations so
+    // that reading past them is caught by address sanitizers
+    const struct {
+        uint8_t bytes[4];
+        std::size_t length;
+    } heads[] = {
+        { { 0x18 }, 1 },                        // one byte argument missing
+        { { 0x19, 0x01 }, 2 },                  // two byte argument cut
+        { { 0x1A, 0x01, 0x02, 0x03 }, 4 },      // four byte argument cut
+        { { 0x1B }, 1 },                        // eight byte argument missing
+        { { 0xD9, 0xD9, 0xF7 }, 3 },            // tag without item
+        { { 0xC1, 0x1B, 0x01 }, 3 },            // item after tag cut
+        { { 0x82, 0x01, 0x1B }, 3 }             // element cut
+    };
+
+    std::size_t truncated = 0;
+
+    for (std::size_t idx = 0; idx < sizeof(heads) / sizeof(heads[0]); idx++)
+    {
+        uint8_t* exact = new uint8_t[heads[idx].length];
+        memcpy(exact, heads[idx].bytes, heads[idx].length);
+
+        std::size_t skipped = 0;
+        std::size_t checked = 0;
+        CborgCursor cursor(exact, heads[idx].length);
+
+        while (cursor.next())
+        {}
+
+        if ((CborgTraverse::skip(exact, heads[idx].length, &skipped) == CborgTraverse::StatusTruncated)
+            && (CborgTraverse::validate(exact, heads[idx].length, &checked) == CborgTraverse::StatusTruncated)
+            && (cursor.getStatus() == CborgTraverse::StatusTruncated))
+        {
+            truncated++;
+        }
+
+        delete[] exact;
+    }
+
+    printf("Truncated heads: %u of %u\r\n", (unsigned) truncated, (unsigned) (sizeof(heads) / sizeof(heads[0])));
+
+    printf("\r\n===============================================================================\r\n");
+}
+
+/*
+    Test 19: bulk scanning.
+*/
+void test19()
+{
+    printf("Test 19: Bulk scanning:\r\n");
+
+    // array of 100 small integers, simple values and a string in the middle
+    uint8_t dense[1 + 1 + 100 + 4];
+    std::size_t length = 0;
+
+    dense[length++] = 0x98;
+    dense[length++] = 101;
+
+    for (std::size_t idx = 0; idx < 100; idx++)
+    {
+        if (idx == 50)
+        {
+            dense[length++] = 0x63;
+            dense[length++] = 'a';
+            dense[length++] = 'b';
+            dense[length++] = 'c';
+        }
+
+        dense[length++] = (idx % 3 == 0) ? (idx % 24) : (idx % 3 == 1) ? (0x20 | (idx % 24)) : (0xE0 | (idx % 24));
+    }
+
+    const CborgScan::Scan_t implementations[] = { CborgScan::ScanScalar, CborgScan::ScanSSE2, CborgScan::ScanAVX2 };
+    CborgScan::Scan_t original = CborgScan::getImplementation();
+
+    for (std::size_t idx = 0; idx < 3; idx++)
+    {
+        CborgScan::setImplementation(implementations[idx]);
+
+        std::size_t skipped = 0;
+        std::size_t validated = 0;
+
+        CborgTraverse::skip(dense, length, &skipped);
+        CborgTraverse::validate(dense, length, &validated);
+
+        Cborg checked = Cborg::validate(dense, length);
+
+        printf("Run: %u, skip: %u, validate: %u, unchecked: %" PRIu32 ", at(51): %u\r\n",
+               (unsigned) CborgScan::immediates(&dense[2], length - 2),
+               (unsigned) skipped, (unsigned) validated, (uint32_t) checked.getCBORLength(),
+               (unsigned) checked.at(51).getType());
+    }
+
+    // UTF-8 validation
+    const struct {
+        const char* name;
+        uint8_t cbor[6];
+        std::size_t length;
+    } texts[] = {
+        { "ascii",              { 0x63, 'a', 'b', 'c' }, 4 },
+        { "two byte",           { 0x62, 0xC3, 0xA6 }, 3 },
+        { "four byte",          { 0x64, 0xF0, 0x9F, 0x98, 0x80 }, 5 },
+        { "overlong",           { 0x62, 0xC0, 0x80 }, 3 },
+        { "surrogate",          { 0x63, 0xED, 0xA0, 0x80 }, 4 },
+        { "too large",          { 0x64, 0xF4, 0x90, 0x80, 0x80 }, 5 },
+        { "cut sequence",       { 0x62, 0x61, 0xE2 }, 3 },
+        { "bytes not checked",  { 0x42, 0xFF, 0xFE }, 3 },
+    };
+
+    for (std::size_t idx = 0; idx < sizeof(texts) / sizeof(texts[0]); idx++)
+    {
+        std::size_t textLength = 0;
+        CborgTraverse::Status_t status = CborgTraverse::validate(texts[idx].cbor, texts[idx].length, &textLength);
+
+        printf("%s: %u\r\n", texts[idx].name, (unsigned) status);
+    }
+
+    CborgScan::setImplementation(original);
+
+    printf("\r\n===============================================================================\r\n");
+}
+
+void test20()
+{
+    printf("Test 20: 64-bit integers and lengths:\r\n");
+
+    uint8_t buffer[200];
+    Cbore encoder(buffer, sizeof(buffer));
+
+    uint64_t timestamp = 1760659200123456789ULL;
+
+    encoder.map(6)
+                .key("time").value(timestamp)
+                .key("counter").value(0xFFFFFFFFFFFFFFFFULL)
+                .key("offset").value(INT64_MIN)
+                .key("small").value(-5)
+                .key(0x100000005LL).value(1)
+                .key(5).value(2);
+
+    Cborg top(buffer, encoder.getLength());
+    top.print();
+
+    uint64_t time = 0;
+    uint64_t counter = 0;
+    int64_t offset = 0;
+    int64_t small = 0;
+    uint32_t narrow = 0;
+    int32_t narrowNegative = 0;
+
+    bool result = top.find("time").getUnsigned(&time)
+               && top.find("counter").getUnsigned(&counter)
+               && top.find("offset").getNegative(&offset)
+               && top.find("small").getInteger(&small);
+
+    printf("Read: %d, time: %" PRIu64 ", counter: %" PRIu64 ", offset: %" PRId64 ", small: %" PRId64 "\r\n",
+           result, time, counter, offset, small);
+
+    // values that do not fit are refused instead of truncated
+    printf("narrow: %d %d %d\r\n", top.find("time").getUnsigned(&narrow),
+           top.find("offset").getNegative(&narrowNegative), top.find("counter").getInteger(&small));
+
+    // integer keys compare all 64 bits
+    uint32_t value = 0;
+    top.find(5).getUnsigned(&value);
+    printf("find(5): %" PRIu32 "\r\n", value);
+
+    EventPrinter printer;
+    CborgSax::decode(buffer, encoder.getLength(), printer);
+    printf("\r\n");
+
+    CborgCursor cursor(buffer, encoder.getLength());
+    cursor.next();
+    cursor.next();
+    cursor.getUnsigned(&time);
+    printf("cursor: %" PRIu64 "\r\n", time);
+
+    // lengths beyond the buffer, including ones that would wrap around
+    const uint8_t huge[] = { 0x5B, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    const uint8_t wrap[] = { 0x81, 0x5B, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01 };
+    const uint8_t count[] = { 0x9B, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x01 };
+
+    std::size_t length = 0;
+
+    printf("huge: %u %u\r\n", (unsigned) CborgTraverse::skip(huge, sizeof(huge), &length),
+           (unsigned) CborgTraverse::validate(huge, sizeof(huge), &length));
+    printf("wrap: %u %u\r\n", (unsigned) CborgTraverse::skip(wrap, sizeof(wrap), &length),
+           (unsigned) CborgTraverse::validate(wrap, sizeof(wrap), &length));
+    printf("count: %u %u\r\n", (unsigned) CborgTraverse::skip(count, sizeof(count), &length),
+           (unsigned) CborgTraverse::validate(count, sizeof(count), &length));
+
+    printf("\r\n===============================================================================\r\n");
+}
+
+void test21()
+{
+    printf("Test 21: Floating point:\r\n");
+
+    const double values[] = { 0.0, -0.0, 1.5, 65504.0, 65520.0, 5.960464477539063e-8,
+                              0.1f, 0.1, 1e300, INFINITY, -INFINITY, NAN };
+    const std::size_t count = sizeof(values) / sizeof(values[0]);
+
+    uint8_t buffer[200];
+
+    // same values as given and in shortest form
+    for (std::size_t mode = 0; mode < 2; mode++)
+    {
+        Cbore encoder(buffer, sizeof(buffer));
+        encoder.setFloatMode((mode == 0) ? Cbore::FloatAsGiven : Cbore::FloatShortest);
+
+        encoder.array(count);
+
+        for (std::size_t idx = 0; idx < count; idx++)
+        {
+            encoder.item(values[idx]);
+        }
+
+        Cborg decoder(buffer, encoder.getLength());
+
+        printf("%s: %u bytes, minor types:", (mode == 0) ? "As given" : "Shortest", (unsigned) encoder.getLength());
+
+        std::size_t exact = 0;
+
+        for (std::size_t idx = 0; idx < count; idx++)
+        {
+            double value = 0;
+            decoder.at(idx).getDouble(&value);
+
+            if ((memcmp(&value, &values[idx], sizeof(value)) == 0) || (isnan(value) && isnan(values[idx])))
+            {
+                exact++;
+            }
+
+            printf(" %u", decoder.at(idx).getMinorType());
+        }
+
+        printf(", exact: %u\r\n", (unsigned) exact);
+    }
+
+    // float accessors
+    Cbore encoder(buffer, sizeof(buffer));
+    encoder.setFloatMode(Cbore::FloatShortest);
+    encoder.map(3)
+                .key("half").value(0.25f)
+                .key("single").value(3.14159274f)
+                .key("double").value(3.141592653589793);
+
+    Cborg top(buffer, encoder.getLength());
+    top.print();
+
+    float single = 0;
+    double wide = 0;
+
+    bool half = top.find("half").getFloat(&single);
+    printf("half: %d %g\r\n", half, single);
+
+    bool narrow = top.find("double").getFloat(&single);
+    bool widened = top.find("double").getDouble(&wide);
+    printf("double as float: %d, as double: %d %.15f\r\n", narrow, widened, wide);
+
+    // bulk array of floats in shortest form
+    float samples[100];
+
+    for (std::size_t idx = 0; idx < 100; idx++)
+    {
+        samples[idx] = (idx % 10 == 9) ? 0.1f * idx : 0.5f * idx;
+    }
+
+    uint8_t bulk[600];
+    Cbore bulkEncoder(bulk, sizeof(bulk));
+    bulkEncoder.setFloatMode(Cbore::FloatShortest);
+    bulkEncoder.array(samples, 100);
+
+    float decoded[100];
+    std::size_t read = Cborg(bulk, bulkEncoder.getLength()).getFloats(decoded, 100);
+
+    printf("Bulk: %u bytes, read: %u, equal: %d\r\n", (unsigned) bulkEncoder.getLength(), (unsigned) read,
+           memcmp(samples, decoded, sizeof(samples)) == 0);
+
+    // bulk conversion matches the scalar conversion for every half
+    const CborgFloat::Convert_t implementations[] = { CborgFloat::ConvertScalar, CborgFloat::ConvertF16C };
+    CborgFloat::Convert_t original = CborgFloat::getImplementation();
+
+    uint16_t* halves = new uint16_t[65536];
+    float* floats = new float[65536];
+    uint16_t* back = new uint16_t[65536];
+
+    for (std::size_t idx = 0; idx < 65536; idx++)
+    {
+        halves[idx] = idx;
+    }
+
+    for (std::size_t idx = 0; idx < 2; idx++)
+    {
+        CborgFloat::setImplementation(implementations[idx]);
+        CborgFloat::halfToFloat(halves, floats, 65536);
+        CborgFloat::floatToHalf(floats, back, 65536);
+
+        std::size_t mismatches = 0;
+
+        for (std::size_t value = 0; value < 65536; value++)
+        {
+            float scalar = CborgFloat::halfToFloat(halves[value]);
+
+            // NaNs come back quiet
+            uint16_t expected = (((value & 0x7C00) == 0x7C00) && (value & 0x03FF)) ? (value | 0x0200) : value;
+
+            if ((memcmp(&scalar, &floats[value], sizeof(float)) != 0) || (back[value] != expected))
+            {
+                mismatches++;
+            }
+        }
+
+        printf("Round trip mismatches: %u\r\n", (unsigned) mismatches);
+    }
+
+    delete[] halves;
+    delete[] floats;
+    delete[] back;
+
+    CborgFloat::setImplementation(original);
+
+    printf("\r\n===============================================================================\r\n");
+}
+
+void test22()
+{
+    printf("Test 22: Typed arrays:\r\n");
+
+    uint16_t waveform[100];
+    int32_t offsets[] = { -1, 0, 1, 100000, -100000 };
+    double levels[] = { 0.5, -1.25, 1e100 };
+
+    for (std::size_t idx = 0; idx < 100; idx++)
+    {
+        waveform[idx] = idx * 600;
+    }
+
+    // 8 byte aligned buffer
+    uint64_t storage[64];
+    uint8_t* buffer = (uint8_t*) storage;
+
+    Cbore encoder(buffer, sizeof(storage));
+    encoder.map(3)
+                .key("w").typedArray(waveform, 100)
+                .key("offsets").typedArray(offsets, 5)
+                .key("levels").typedArray(levels, 3);
+
+    Cborg top(buffer, encoder.getLength());
+
+    printf("Encoded: %u bytes, tags: %" PRIu32 " %" PRIu32 " %" PRIu32 "\r\n", (unsigned) encoder.getLength(),
+           top.find("w").getTag(), top.find("offsets").getTag(), top.find("levels").getTag());
+
+    uint16_t copy[100];
+
+    CborgTypedArray<uint16_t> wave = top.find("w").getTypedArray(copy, 100);
+    printf("Waveform: %u values, copy: %d, last: %u\r\n", (unsigned) wave.size(), wave.isCopy(), wave[99]);
+
+    int32_t offsetCopy[5];
+    CborgTypedArray<int32_t> offsetView = top.find("offsets").getTypedArray(offsetCopy, 5);
+    printf("Offsets: copy: %d,", offsetView.isCopy());
+
+    for (const int32_t* value = offsetView.begin(); value != offsetView.end(); value++)
+    {
+        printf(" %" PRId32, *value);
+    }
+
+    printf("\r\n");
+
+    // misaligned payload can not be read in place
+    double levelCopy[3];
+    CborgTypedArray<double> levelView = top.find("levels").getTypedArray(levelCopy, 3);
+    printf("Levels: copy: %d, %g %g %g\r\n", levelView.isCopy(), levelView[0], levelView[1], levelView[2]);
+
+    // payload after a two byte tag and two byte header is read in place
+    Cbore single(buffer, sizeof(storage));
+    single.typedArray(waveform, 100);
+
+    CborgTypedArray<uint16_t> inPlace = Cborg(buffer, single.getLength()).getTypedArray<uint16_t>();
+    printf("In place: valid: %d, copy: %d, offset: %u, last: %u\r\n", inPlace.isValid(), inPlace.isCopy(),
+           (unsigned) ((const uint8_t*) inPlace.data() - buffer), inPlace[99]);
+
+    // wrong element type, missing buffer
+    printf("As int16: %d, without buffer: %d\r\n",
+           top.find("w").getTypedArray<int16_t>(NULL, 0).isValid(),
+           top.find("levels").getTypedArray<double>().isValid());
+
+    // the other byte order is swapped while copying
+    uint8_t foreign[] = { 0xD8, (uint8_t) (CborgTyped::tag<uint32_t>() ^ CborgTyped::TagLittleEndian), 0x48,
+                          0x01, 0x02, 0x03, 0x04, 0x0A, 0x0B, 0x0C, 0x0D };
+    uint32_t swapped[2];
+    CborgTypedArray<uint32_t> foreignView = Cborg(foreign, sizeof(foreign)).getTypedArray(swapped, 2);
+    printf("Foreign: copy: %d, %08" PRIX32 " %08" PRIX32 "\r\n", foreignView.isCopy(), foreignView[0], foreignView[1]);
+
+    // vector byte swapping matches the scalar version
+    const CborgScan::Scan_t implementations[] = { CborgScan::ScanScalar, CborgScan::ScanSSE2, CborgScan::ScanAVX2 };
+    CborgScan::Scan_t original = CborgScan::getImplementation();
+
+    uint8_t source[301];
+    uint8_t expected[301];
+    uint8_t result[301];
+
+    for (std::size_t idx = 0; idx < sizeof(source); idx++)
+    {
+        source[idx] = idx * 7 + 3;
+    }
+
+    std::size_t mismatches = 0;
+
+    for (std::size_t width = 1; width <= 8; width *= 2)
+    {
+        for (std::size_t count = 0; count * width <= 300; count += 3)
+        {
+            CborgScan::setImplementation(CborgScan::ScanScalar);
+            CborgTyped::swap(&source[1], expected, count, width);
+
+            for (std::size_t idx = 1; idx < 3; idx++)
+            {
+                CborgScan::setImplementation(implementations[idx]);
+                CborgTyped::swap(&source[1], result, count, width);
+
+                mismatches += (memcmp(expected, result, count * width) != 0);
+            }
+        }
+    }
+
+    CborgScan::setImplementation(original);
+
+    printf("Swap mismatches: %u\r\n", (unsigned) mismatches);
+
+    printf("\r\n===============================================================================\r\n");
+}
+
+/*
+    Test 23: output sinks.
+*/
+static void encodeDocument(Cbore& encoder)
+{
+    static uint8_t block[1000];
+    static char label[300];
+    int32_t offsets[] = { -1, 0, 1, 100000, -100000 };
+
+    for (std::size_t idx = 0; idx < sizeof(block); idx++)
+    {
+        block[idx] = idx * 13;
+    }
+
+    for (std::size_t idx = 0; idx < sizeof(label); idx++)
+    {
+        label[idx] = 'a' + idx % 26;
+    }
+
+    encoder.map(5)
+                .key("block").value(block, sizeof(block))
+                .key("label").value(label, sizeof(label))
+                .key("offsets").typedArray(offsets, 5)
+                .key("level").value(0.5f)
+                .key("readings").array(500);
+
+    for (std::size_t idx = 0; idx < 500; idx++)
+    {
+        encoder.item((int64_t) idx * idx * 1000 - 70000);
+    }
+}
+
+static bool appendOutput(const uint8_t* data, std::size_t length, void* context)
+{
+    ((std::string*) context)->append((const char*) data, length);
+
+    return true;
+}
+
+void test23()
+{
+    printf("Test 23: Output sinks:\r\n");
+
+    static uint8_t reference[8 * 1024];
+
+    Cbore fixed(reference, sizeof(reference));
+    encodeDocument(fixed);
+
+    printf("Fixed: %u bytes\r\n", (unsigned) fixed.getLength());
+
+    // growable vector
+    std::vector<uint8_t> output;
+    CboreVectorSink vectorSink(output);
+
+    Cbore growing(vectorSink);
+    encodeDocument(growing);
+    bool flushed = growing.flush();
+
+    printf("Vector: %u bytes, flushed: %d, equal: %d\r\n", (unsigned) output.size(), flushed,
+           (output.size() == fixed.getLength()) && (memcmp(&output[0], reference, output.size()) == 0));
+
+    // chain of 64 byte blocks, decoded in place
+    CboreBlockSink blockSink(64);
+
+    Cbore chained(blockSink);
+    encodeDocument(chained);
+    chained.flush();
+
+    std::vector<CborgSegment> segments;
+    std::string joined;
+
+    for (std::size_t idx = 0; idx < blockSink.getBlocks(); idx++)
+    {
+        const std::vector<uint8_t>& current = blockSink.getBlock(idx);
+
+        CborgSegment segment = { &current[0], current.size() };
+        segments.push_back(segment);
+
+        joined.append((const char*) &current[0], current.size());
+    }
+
+    CborgScatter scatter(&segments[0], segments.size());
+    std::string label;
+    scatter.find("label").getString(label);
+
+    int64_t last = 0;
+    scatter.find("readings").at(499).getInteger(&last);
+
+    printf("Blocks: %u, length: %u, equal: %d, label: %u, last: %" PRId64 "\r\n",
+           (unsigned) blockSink.getBlocks(), (unsigned) chained.getLength(),
+           (joined.size() == fixed.getLength()) && (memcmp(joined.data(), reference, joined.size()) == 0),
+           (unsigned) label.size(), last);
+
+    // bounded buffer flushed through a callback
+    uint8_t window[32];
+    std::string written;
+    CboreCallbackSink callbackSink(window, sizeof(window), appendOutput, &written);
+
+    Cbore streaming(callbackSink);
+    encodeDocument(streaming);
+
+    printf("Callback: %u bytes written before flush,", (unsigned) written.size());
+
+    streaming.flush();
+
+    printf(" %u after, equal: %d\r\n", (unsigned) written.size(),
+           (written.size() == fixed.getLength()) && (memcmp(written.data(), reference, written.size()) == 0));
+
+    // headers never straddle a window, blocks too small for one fail
+    CboreBlockSink tinySink(4);
+    Cbore tiny(tinySink);
+    tiny.item((uint64_t) 1 << 40).item(7);
+    tiny.flush();
+
+    printf("Tiny blocks: %u bytes\r\n", (unsigned) tiny.getLength());
+
+    // a fixed buffer still drops items that do not fit
+    uint8_t small[16];
+    Cbore dropping(small, sizeof(small));
+    dropping.array(2).item("fifteen chars..").item(1);
+
+    printf("Fixed overflow: %u bytes\r\n", (unsigned) dropping.getLength());
+
+    printf("\r\n===============================================================================\r\n");
+}
+
+/*
+    Test 24: gather list encoding.
+*/
+void test24()
+{
+    printf("Test 24: Gather list:\r\n");
+
+    static uint8_t firmware[64 * 1024];
+    static uint8_t digest[32];
+
+    for (std::size_t idx = 0; idx < sizeof(firmware); idx++)
+    {
+        firmware[idx] = idx * 31;
+    }
+
+    for (std::size_t idx = 0; idx < sizeof(digest); idx++)
+    {
+        digest[idx] = idx;
+    }
+
+    // headers and small items only, the image is referenced
+    uint8_t headers[128];
+    CboreGatherSink sink(headers, sizeof(headers), 1024);
+
+    Cbore encoder(sink);
+    encoder.map(4)
+                .key("name").value("firmware")
+                .key("version").value(3)
+                .key("image").value(firmware, sizeof(firmware))
+                .key("digest").value(digest, sizeof(digest));
+    encoder.flush();
+
+    const CborgSegment* segments = sink.getSegments();
+
+    printf("Length: %u, segments: %u, referenced: %d\r\n", (unsigned) encoder.getLength(),
+           (unsigned) sink.getCount(), segments[1].data == firmware);
+
+    for (std::size_t idx = 0; idx < sink.getCount(); idx++)
+    {
+        printf("  %u bytes%s\r\n", (unsigned) segments[idx].length, (segments[idx].data == firmware) ? ", image" : "");
+    }
+
+    // same bytes as a plain encoding
+    static uint8_t reference[66 * 1024];
+
+    Cbore plain(reference, sizeof(reference));
+    plain.map(4)
+                .key("name").value("firmware")
+                .key("version").value(3)
+                .key("image").value(firmware, sizeof(firmware))
+                .key("digest").value(digest, sizeof(digest));
+
+    std::size_t position = 0;
+    bool equal = (plain.getLength() == encoder.getLength());
+
+    for (std::size_t idx = 0; equal && (idx < sink.getCount()); idx++)
+    {
+        equal = (memcmp(&reference[position], segments[idx].data, segments[idx].length) == 0);
+        position += segments[idx].length;
+    }
+
+    printf("Equal: %d\r\n", equal);
+
+    // decoding the segments finds the image in place
+    CborgScatter scatter(segments, sink.getCount());
+
+    const uint8_t* image = NULL;
+    uint32_t imageLength = 0;
+    scatter.find("image").getBytes(&image, &imageLength);
+
+    printf("Image in place: %d, length: %" PRIu32 "\r\n", image == firmware, imageLength);
+
+    // nothing is written past the end of the buffer
+    uint8_t tiny[8];
+    CboreGatherSink tinySink(tiny, sizeof(tiny), 1024);
+
+    Cbore overflow(tinySink);
+    overflow.array(3).item("name").item(firmware, sizeof(firmware)).item("too long for the rest");
+    overflow.flush();
+
+    printf("Small buffer: %u bytes, segments: %u\r\n", (unsigned) overflow.getLength(), (unsigned) tinySink.getCount());
+
+    printf("\r\n===============================================================================\r\n");
+}
+
+/*
+    Test 25: back-patched container counts.
+*/
+static void printHex(const uint8_t* data, std::size_t length)
+{
+    for (std::size_t idx = 0; idx < length; idx++)
+    {
+        printf("%02X", data[idx]);
+    }
+
+    printf("\r\n");
+}
+
+static void encodeNested(Cbore& encoder)
+{
+    encoder.array()
+                .item(1)
+                .map()
+                    .key("a").value(2)
+                    .key("b").array(2).item(3).map(0)
+                .end()
+                .tag(1).item(1500000000)
+                .array(2).item("x").array().end()
+           .end();
+}
+
+void test25()
+{
+    printf("Test 25: Patched containers:\r\n");
+
+    uint8_t buffer[64];
+
+    Cbore indefinite(buffer, sizeof(buffer));
+    encodeNested(indefinite);
+    printf("Indefinite: ");
+    printHex(buffer, indefinite.getLength());
+
+    Cbore patched(buffer, sizeof(buffer));
+    patched.setContainerMode(Cbore::ContainerPatch);
+    encodeNested(patched);
+    printf("Patch:      ");
+    printHex(buffer, patched.getLength());
+
+    Cborg decoded = Cborg::validate(buffer, patched.getLength());
+    printf("Valid: %d, items: %" PRIu32 ", map: %" PRIu32 "\r\n", decoded.isValidated(),
+           decoded.getSize(), decoded.at(1).getSize());
+
+    Cbore compact(buffer, sizeof(buffer));
+    compact.setContainerMode(Cbore::ContainerCompact);
+    encodeNested(compact);
+    printf("Compact:    ");
+    printHex(buffer, compact.getLength());
+
+    // same bytes as counting by hand
+    uint8_t expected[64];
+
+    Cbore definite(expected, sizeof(expected));
+    definite.array(4)
+                .item(1)
+                .map(2)
+                    .key("a").value(2)
+                    .key("b").array(2).item(3).map(0)
+                .tag(1).item(1500000000)
+                .array(2).item("x").array(0);
+
+    printf("Equal: %d\r\n", (compact.getLength() == definite.getLength())
+                               && (memcmp(buffer, expected, definite.getLength()) == 0));
+
+    // the open container needs two bytes more than its final encoding
+    uint8_t tight[4];
+
+    Cbore exact(tight, 2);
+    exact.setContainerMode(Cbore::ContainerCompact);
+    exact.array().item(1).end();
+
+    Cbore roomy(tight, 4);
+    roomy.setContainerMode(Cbore::ContainerCompact);
+    roomy.array().item(1).end();
+
+    printf("Two bytes: overflow: %d, four bytes: overflow: %d, ", exact.hasOverflow(), roomy.hasOverflow());
+    printHex(tight, roomy.getLength());
+
+    // indefinite container inside a patched one
+    Cbore mixed(buffer, sizeof(buffer));
+    mixed.setContainerMode(Cbore::ContainerCompact);
+    mixed.array().item(1);
+    mixed.setContainerMode(Cbore::ContainerIndefinite);
+    mixed.map().key(1).value(2).end().item(3).end();
+    printf("Mixed:      ");
+    printHex(buffer, mixed.getLength());
+
+    // counts beyond two bytes move the contents up
+    std::vector<uint8_t> output;
+    CboreVectorSink vectorSink(output);
+
+    Cbore large(vectorSink);
+    large.setContainerMode(Cbore::ContainerPatch);
+    large.array();
+
+    for (std::size_t idx = 0; idx < 70000; idx++)
+    {
+        large.item(idx % 24);
+    }
+
+    large.end();
+    large.flush();
+
+    Cborg array = Cborg::validate(&output[0], output.size());
+    uint32_t last = 0;
+    array.at(69999).getUnsigned(&last);
+
+    printf("Large: %u bytes, header: %02X, valid: %d, items: %" PRIu32 ", last: %" PRIu32 "\r\n",
+           (unsigned) output.size(), output[0], array.isValidated(), array.getSize(), last);
+
+    // flushing sink keeps open headers in the window
+    uint8_t window[24];
+    std::string written;
+    CboreCallbackSink callbackSink(window, sizeof(window), appendOutput, &written);
+
+    Cbore streaming(callbackSink);
+    streaming.setContainerMode(Cbore::ContainerCompact);
+    streaming.array(3);
+
+    for (std::size_t record = 0; record < 3; record++)
+    {
+        streaming.map().key("id").value(record).key("name").value("sensor").end();
+    }
+
+    streaming.flush();
+
+    Cbore records(expected, sizeof(expected));
+    records.array(3);
+
+    for (std::size_t record = 0; record < 3; record++)
+    {
+        records.map(2).key("id").value(record).key("name").value("sensor");
+    }
+
+    printf("Streamed: %u bytes, equal: %d\r\n", (unsigned) written.size(),
+           (written.size() == records.getLength()) && (memcmp(written.data(), expected, written.size()) == 0));
+
+    printf("\r\n===============================================================================\r\n");
+}
+
+/*
+    Test 26: measuring without a buffer.
+*/
+static bool measure(std::size_t counted, std::size_t encoded)
+{
+    printf("%u / %u bytes\r\n", (unsigned) counted, (unsigned) encoded);
+
+    return counted == encoded;
+}
+
+void test26()
+{
+    printf("Test 26: Measuring:\r\n");
+
+    static uint8_t buffer[8 * 1024];
+    bool equal = true;
+
+    // strings, typed arrays, floats and integers
+    CboreCountSink documentCounter;
+    Cbore documentCount(documentCounter);
+    encodeDocument(documentCount);
+
+    Cbore document(buffer, sizeof(buffer));
+    encodeDocument(document);
+
+    printf("Document:  ");
+    equal = measure(documentCount.getLength(), document.getLength()) && equal;
+
+    // patched headers that are discarded before end()
+    Cbore::ContainerMode_t modes[] = { Cbore::ContainerIndefinite, Cbore::ContainerPatch, Cbore::ContainerCompact };
+    const char* names[] = { "Indefinite:", "Patch:     ", "Compact:   " };
+
+    for (std::size_t mode = 0; mode < 3; mode++)
+    {
+        CboreCountSink nestedCounter;
+        Cbore nestedCount(nestedCounter);
+        nestedCount.setContainerMode(modes[mode]);
+        encodeNested(nestedCount);
+
+        Cbore nested(buffer, sizeof(buffer));
+        nested.setContainerMode(modes[mode]);
+        encodeNested(nested);
+
+        printf("%s ", names[mode]);
+        equal = measure(nestedCount.getLength(), nested.getLength()) && equal;
+    }
+
+    // header grows beyond the reserved width
+    std::vector<uint8_t> output;
+    CboreVectorSink vectorSink(output);
+    Cbore large(vectorSink);
+    large.setContainerMode(Cbore::ContainerCompact);
+
+    CboreCountSink largeCounter;
+    Cbore largeCount(largeCounter);
+    largeCount.setContainerMode(Cbore::ContainerCompact);
+
+    large.array().item("values").map();
+    largeCount.array().item("values").map();
+
+    for (std::size_t idx = 0; idx < 70000; idx++)
+    {
+        large.key(idx).value(-1.5);
+        largeCount.key(idx).value(-1.5);
+    }
+
+    large.end().end();
+    large.flush();
+    largeCount.end().end();
+
+    printf("Large:     ");
+    equal = measure(largeCount.getLength(), output.size()) && equal;
+
+    // shortest floats
+    double values[] = { 0.0, 1.0, 0.1, 65504.0, 1.0e-7, 3.4e38, 1.0e300 };
+
+    CboreCountSink floatCounter;
+    Cbore floatCount(floatCounter);
+    floatCount.setFloatMode(Cbore::FloatShortest);
+
+    Cbore floats(buffer, sizeof(buffer));
+    floats.setFloatMode(Cbore::FloatShortest);
+
+    for (std::size_t idx = 0; idx < sizeof(values) / sizeof(values[0]); idx++)
+    {
+        floatCount.item(values[idx]);
+        floats.item(values[idx]);
+    }
+
+    printf("Floats:    ");
+    equal = measure(floatCount.getLength(), floats.getLength()) && equal;
+
+    printf("Equal: %d\r\n", equal);
+
+    printf("\r\n===============================================================================\r\n");
+}
+
+/*
+    Test 27: stencils.
+*/
+void test27()
+{
+    printf("Test 27: Stencils:\r\n");
+
+    uint8_t storage[128];
+    std::size_t sequence, offset, temperature, energy, uptime;
+
+    Cbore encoder(storage, sizeof(storage));
+    encoder.map(4)
+                .key("device").value("sensor-17")
+                .key("seq").slot(Cbore::SlotInteger32, &sequence)
+                .key("values").array(3)
+                    .slot(Cbore::SlotInteger32, &offset)
+                    .slot(Cbore::SlotFloat, &temperature)
+                    .slot(Cbore::SlotDouble, &energy)
+                .key("uptime").slot(Cbore::SlotInteger64, &uptime);
+
+    CboreStencil stencil(storage, encoder.getLength());
+
+    printf("Stencil: ");
+    printHex(storage, stencil.getLength());
+    printf("Slots: %u %u %u %u %u\r\n", (unsigned) sequence, (unsigned) offset,
+           (unsigned) temperature, (unsigned) energy, (unsigned) uptime);
+
+    uint8_t message[128];
+    uint8_t expected[128];
+    bool equal = true;
+
+    for (uint32_t idx = 0; idx < 3; idx++)
+    {
+        int32_t delta = (idx == 1) ? -100000 - (int32_t) idx : 100000 + idx;
+
+        std::size_t length = stencil.copy(message, sizeof(message));
+        CboreStencil::setUnsigned(message, sequence, 0x10000 + idx);
+        CboreStencil::setInteger(message, offset, delta);
+        CboreStencil::setFloat(message, temperature, 20.5f + idx);
+        CboreStencil::setDouble(message, energy, 0.1 * idx);
+        CboreStencil::setInteger64(message, uptime, (idx == 2) ? -5000000000LL : 5000000000LL);
+
+        // values that need the full width encode to the same bytes
+        Cbore plain(expected, sizeof(expected));
+        plain.map(4)
+                .key("device").value("sensor-17")
+                .key("seq").value(0x10000 + idx)
+                .key("values").array(3)
+                    .item(delta)
+                    .item(20.5f + idx)
+                    .item(0.1 * idx)
+                .key("uptime").value((idx == 2) ? -5000000000LL : 5000000000LL);
+
+        equal = equal && (length == plain.getLength()) && (memcmp(message, expected, length) == 0);
+
+        Cborg decoder(message, length);
+        uint32_t seq = 0;
+        int64_t value = 0;
+        float celsius = 0;
+        decoder.find("seq").getUnsigned(&seq);
+        decoder.find("values").at(0).getInteger(&value);
+        decoder.find("values").at(1).getFloat(&celsius);
+
+        printf("Message %" PRIu32 ": seq: %" PRIu32 ", offset: %" PRId64 ", temperature: %.1f\r\n",
+               idx, seq, value, celsius);
+    }
+
+    printf("Equal: %d\r\n", equal);
+
+    // slots are counted as items of patched containers
+    Cbore patched(storage, sizeof(storage));
+    patched.setContainerMode(Cbore::ContainerCompact);
+    patched.array().slot(Cbore::SlotInteger32, &offset).slot(Cbore::SlotFloat, &temperature).end();
+
+    printf("Patched: ");
+    printHex(storage, patched.getLength());
+
+    // too small
+    uint8_t tiny[8];
+    printf("Small buffer: %u\r\n", (unsigned) stencil.copy(tiny, sizeof(tiny)));
+
+    printf("\r\n===============================================================================\r\n");
+}
+
+/*
+    Test 28: compile-time constants.
+*/
+static const uint8_t constantSerial[] = { 0xDE, 0xAD, 0xBE, 0xEF };
+
+static constexpr auto constantHeader = CboreConstant::encode(
+    CboreConstant::join(CboreConstant::string("device"), CboreConstant::string("sensor-17"),
+                        CboreConstant::string("serial"), CboreConstant::bytes(constantSerial),
+                        CboreConstant::string("limits"), CboreConstant::array<4>(),
+                            CboreConstant::integer<-1>(), CboreConstant::integer<1000>(),
+                            CboreConstant::integer<-100000>(), CboreConstant::integer<5000000000LL>(),
+                        CboreConstant::string("flags"), CboreConstant::tag<1>(),
+                            CboreConstant::simple<CborBase::TypeTrue>()));
+
+static const std::size_t constantBound = CboreSize::header(4)
+    + sizeof(constantHeader)
+    + CboreSize::literal("reading") + CboreSize::integer(INT32_MIN);
+
+static_assert(sizeof(constantHeader) == 63, "constant size");
+static_assert(constantBound == 77, "size bound");
+
+void test28()
+{
+    printf("Test 28: Compile-time constants:\r\n");
+
+    printf("Constant: ");
+    printHex(constantHeader.data(), constantHeader.size());
+
+    // same bytes as the fluent chain
+    uint8_t expected[constantBound];
+    Cbore plain(expected, sizeof(expected));
+    plain.map(4)
+            .key("device").value("sensor-17")
+            .key("serial").value(constantSerial, sizeof(constantSerial))
+            .key("limits").array(4).item(-1).item(1000).item(-100000).item(5000000000LL)
+            .key("flags").tag(1).item(CborBase::TypeTrue);
+
+    // after the map header
+    printf("Equal: %d\r\n", (plain.getLength() == constantHeader.size() + 1)
+                               && (memcmp(&expected[1], constantHeader.data(), constantHeader.size()) == 0));
+
+    // the bound fits the largest reading exactly
+    uint8_t buffer[constantBound];
+    Cbore encoder(buffer, sizeof(buffer));
+    encoder.map(4).constant(constantHeader, 6).key("reading").value(INT32_MIN);
+
+    printf("Bound: %u, length: %u\r\n", (unsigned) constantBound, (unsigned) encoder.getLength());
+
+    // constants count as items of patched containers
+    Cbore patched(buffer, sizeof(buffer));
+    patched.setContainerMode(Cbore::ContainerCompact);
+    patched.map().constant(constantHeader, 6).key("reading").value(7).end();
+
+    Cborg decoded = Cborg::validate(buffer, patched.getLength());
+    int64_t limit = 0;
+    decoded.find("limits").at(2).getInteger(&limit);
+
+    printf("Patched: valid: %d, pairs: %" PRIu32 ", limit: %" PRId64 "\r\n",
+           decoded.isValidated(), decoded.getSize(), limit);
+
+    // nothing is written unless the constant fits
+    uint8_t tiny[16];
+    Cbore small(tiny, sizeof(tiny));
+    small.array(2).constant(constantHeader).item(1);
+    printf("Small buffer: %u\r\n", (unsigned) small.getLength());
+
+    // literals through the compile-time header path
+    Cbore literals(expected, sizeof(expected));
+    literals.array(2).item("").item("twenty-four characters!!");
+    printf("Literals: ");
+    printHex(expected, literals.getLength());
+
+    printf("\r\n===============================================================================\r\n");
+}
+
+/*
+    Test 29: raw splice.
+*/
+static void encodePayload(Cbore& encoder, std::size_t readings)
+{
+    encoder.map(3)
+                .key("unit").value("C")
+                .key("time").tag(1).item(1500000000)
+                .key("readings").array(readings);
+
+    for (std::size_t idx = 0; idx < readings; idx++)
+    {
+        encoder.item((int32_t) (idx * 7) - 300);
+    }
+}
+
+void test29()
+{
+    printf("Test 29: Raw splice:\r\n");
+
+    // incoming message with a subdocument to forward
+    uint8_t incoming[256];
+    Cbore sender(incoming, sizeof(incoming));
+    sender.map(3).key("from").value("gateway").key("to").value("cloud").key("payload");
+    encodePayload(sender, 10);
+
+    Cborg message(incoming, sender.getLength());
+
+    uint8_t forwarded[256];
+    Cbore proxy(forwarded, sizeof(forwarded));
+    proxy.map(2).key("via").value("proxy").key("payload").raw(message.find("payload"));
+
+    // same bytes as encoding the payload again
+    uint8_t expected[256];
+    Cbore plain(expected, sizeof(expected));
+    plain.map(2).key("via").value("proxy").key("payload");
+    encodePayload(plain, 10);
+
+    printf("Forwarded: %u bytes, equal: %d\r\n", (unsigned) proxy.getLength(),
+           (proxy.getLength() == plain.getLength()) && (memcmp(forwarded, expected, plain.getLength()) == 0));
+
+    // raw bytes count as items of patched containers
+    const uint8_t pair[] = { 0x61, 0x6B, 0x82, 0x01, 0x02 };
+
+    Cbore patched(forwarded, sizeof(forwarded));
+    patched.setContainerMode(Cbore::ContainerCompact);
+    patched.map().raw(pair, sizeof(pair), 2).key("payload").raw(message.find("payload")).end();
+
+    Cborg decoded = Cborg::validate(forwarded, patched.getLength());
+    uint32_t second = 0;
+    decoded.find("k").at(1).getUnsigned(&second);
+
+    printf("Patched: valid: %d, pairs: %" PRIu32 ", second: %" PRIu32 ", readings: %" PRIu32 "\r\n",
+           decoded.isValidated(), decoded.getSize(), second, decoded.find("payload").find("readings").getSize());
+
+    // large subtrees are referenced by the gather sink
+    static uint8_t large[8 * 1024];
+    Cbore largeSender(large, sizeof(large));
+    largeSender.map(1).key("payload");
+    encodePayload(largeSender, 1000);
+
+    Cborg largeMessage(large, largeSender.getLength());
+
+    uint8_t headers[64];
+    CboreGatherSink sink(headers, sizeof(headers), 1024);
+
+    Cbore gathered(sink);
+    gathered.array(2).item("forwarded").raw(largeMessage.find("payload"));
+    gathered.flush();
+
+    const CborgSegment* segments = sink.getSegments();
+
+    printf("Gathered: %u bytes, segments: %u, referenced: %d\r\n", (unsigned) gathered.getLength(),
+           (unsigned) sink.getCount(), (sink.getCount() == 2) && (segments[1].data > large));
+
+    // truncated subtrees and missing keys are left out
+    Cborg truncated(incoming, sender.getLength() - 1);
+
+    Cbore dropped(forwarded, sizeof(forwarded));
+    dropped.array(2).raw(truncated.find("payload")).raw(message.find("missing"));
+
+    printf("Dropped: %u bytes\r\n", (unsigned) dropped.getLength());
+
+    printf("\r\n===============================================================================\r\n");
+}
+
+/*
+    Test 30: savepoints and overflow.
+*/
+void test30()
+{
+    printf("Test 30: Savepoints:\r\n");
+
+    static uint8_t notes[100];
+    memset(notes, 'n', sizeof(notes));
+
+    // optional section that does not fit is dropped
+    uint8_t buffer[64];
+    Cbore encoder(buffer, sizeof(buffer));
+    encoder.setContainerMode(Cbore::ContainerCompact);
+    encoder.map().key("id").value(7);
+
+    Cbore::Savepoint optional = encoder.savepoint();
+    encoder.key("notes").array().item(notes, 40).item(notes, 40).end();
+
+    printf("Overflow: %d\r\n", encoder.hasOverflow());
+
+    bool restored = encoder.rollback(optional);
+    encoder.key("ok").value(CborBase::TypeTrue).end();
+
+    Cborg decoded = Cborg::validate(buffer, encoder.getLength());
+    printf("Rollback: %d, overflow: %d, valid: %d, pairs: %" PRIu32 "\r\n", restored,
+           encoder.hasOverflow(), decoded.isValidated(), decoded.getSize());
+    printf("Document: ");
+    printHex(buffer, encoder.getLength());
+
+    // definite containers count again from the savepoint
+    Cbore definite(buffer, sizeof(buffer));
+    definite.setContainerMode(Cbore::ContainerPatch);
+    definite.array().array(2).item(1);
+
+    Cbore::Savepoint inner = definite.savepoint();
+    definite.item(2).item(3);
+    definite.rollback(inner);
+    definite.item(4).item(5).end();
+
+    printf("Definite: ");
+    printHex(buffer, definite.getLength());
+
+    // closed patched containers can not be reopened
+    Cbore closed(buffer, sizeof(buffer));
+    closed.setContainerMode(Cbore::ContainerCompact);
+    closed.array().item(1);
+
+    Cbore::Savepoint open = closed.savepoint();
+    closed.end();
+
+    printf("Closed: %d\r\n", closed.rollback(open));
+
+    // data already passed to the sink can not be taken back
+    uint8_t window[16];
+    std::string written;
+    CboreCallbackSink callbackSink(window, sizeof(window), appendOutput, &written);
+
+    Cbore streaming(callbackSink);
+    streaming.array(3).item(1);
+
+    Cbore::Savepoint early = streaming.savepoint();
+    streaming.item(notes, sizeof(notes));
+
+    printf("Flushed: %d, overflow: %d\r\n", streaming.rollback(early), streaming.hasOverflow());
+
+    // nesting too deep is an overflow as well
+    Cbore deep(buffer, sizeof(buffer));
+    deep.setContainerMode(Cbore::ContainerPatch);
+
+    for (std::size_t idx = 0; idx < CBORG_MAX_DEPTH + 1; idx++)
+    {
+        deep.array();
+    }
+
+    printf("Too deep: %d\r\n", deep.hasOverflow());
+
+    deep.reset(false);
+    printf("Reset: %d\r\n", deep.hasOverflow());
+
+    printf("\r\n===============================================================================\r\n");
+}
+
+/*
+    Test 31: arena document.
+*/
+void test31()
+{
+    printf("Test 31: Arena document:\r\n");
+
+    static uint8_t storage[2048];
+    CborArena arena(storage, sizeof(storage));
+
+    // built out of order: containers are filled after they are attached
+    CborNode* root = arena.map();
+    CborNode* readings = arena.array();
+    CborNode* location = arena.map(2);
+
+    arena.insert(root, arena.string("id"), arena.integer(7));
+    arena.insert(root, arena.string("readings"), readings);
+    arena.insert(root, arena.string("location"), location);
+
+    for (int32_t idx = 0; idx < 10; idx++)
+    {
+        arena.append(readings, arena.integer(idx * 1000 - 3000));
+    }
+
+    arena.insert(location, arena.string("lat"), arena.floating(55.5));
+    arena.insert(location, arena.string("valid"), arena.simple(CborBase::TypeTrue));
+
+    CborNode* time = arena.integer(1500000000);
+    time->setTag(1);
+    arena.insert(root, arena.string("time"), time);
+
+    const uint8_t blob[] = { 0x01, 0x02, 0x03 };
+    arena.insert(root, arena.string("blob"), arena.bytes(blob, sizeof(blob)));
+
+    // replace the id afterwards
+    arena.replace(root, 0, arena.integer(-8));
+
+    uint8_t buffer[256];
+    uint32_t length = root->writeCBOR(buffer, sizeof(buffer));
+
+    // same bytes as the fluent chain
+    uint8_t expected[256];
+    Cbore plain(expected, sizeof(expected));
+    plain.map(5)
+            .key("id").value(-8)
+            .key("readings").array(10);
+
+    for (int32_t idx = 0; idx < 10; idx++)
+    {
+        plain.item(idx * 1000 - 3000);
+    }
+
+    plain.key("location").map(2).key("lat").value(55.5).key("valid").value(CborBase::TypeTrue)
+         .key("time").tag(1).item(1500000000)
+         .key("blob").value(blob, sizeof(blob));
+
+    printf("Length: %" PRIu32 ", equal: %d\r\n", length,
+           (length == plain.getLength()) && (memcmp(buffer, expected, length) == 0));
+
+    // navigation through CborBase and CborNode
+    int64_t last = 0;
+    double latitude = 0;
+    ((CborNode*) root->find("readings")->at(9))->getInteger(&last);
+    root->find("location")->find("lat")->getDouble(&latitude);
+
+    printf("Pairs: %" PRIu32 ", readings: %" PRIu32 ", last: %" PRId64 ", lat: %.1f\r\n",
+           root->getSize(), root->find("readings")->getSize(), last, latitude);
+
+    root->print();
+
+    // patched encoders see the same document
+    Cbore compact(buffer, sizeof(buffer));
+    compact.setContainerMode(Cbore::ContainerCompact);
+    compact.array();
+    root->encode(compact);
+    compact.end();
+
+    printf("Wrapped: %u bytes, valid: %d\r\n", (unsigned) compact.getLength(),
+           Cborg::validate(buffer, compact.getLength()).isValidated());
+
+    // reset drops everything at once, full arena fails safely
+    std::size_t used = arena.getUsed();
+    arena.reset();
+
+    uint8_t small[128];
+    CborArena smallArena(small, sizeof(small));
+    CborNode* list = smallArena.array();
+    std::size_t appended = 0;
+
+    while (smallArena.append(list, smallArena.integer(appended)))
+    {
+        appended++;
+    }
+
+    printf("Reset: %d, small arena items: %u\r\n", (used > 0) && (arena.getUsed() == 0), (unsigned) list->getSize());
+
+    // buffer that starts one byte past an aligned address
+    alignas(8) static uint8_t unaligned[1 + 1024];
+    CborArena offsetArena(&unaligned[1], sizeof(unaligned) - 1);
+
+    CborNode* document = offsetArena.map();
+    CborNode* values = offsetArena.array();
+
+    offsetArena.insert(document, offsetArena.string("values"), values);
+
+    for (int32_t idx = 0; idx < 6; idx++)
+    {
+        offsetArena.append(values, offsetArena.integer(idx));
+    }
+
+    offsetArena.insert(document, offsetArena.string("ok"), offsetArena.simple(CborBase::TypeTrue));
+
+    uint8_t unalignedOutput[64];
+    uint32_t unalignedLength = document->writeCBOR(unalignedOutput, sizeof(unalignedOutput));
+
+    printf("Offset buffer: aligned: %d, ", (((uintptr_t) document % alignof(CborNode)) == 0)
+                                           && (((uintptr_t) values % alignof(CborNode)) == 0));
+    printHex(unalignedOutput, unalignedLength);
+
+    // floats, break and the two byte form are rejected as simple values
+    printf("Simple: %d %d %d %d\r\n", offsetArena.simple(CborBase::TypeUndefined) != NULL,
+           offsetArena.simple(CborBase::TypeHalfFloat) == NULL, offsetArena.simple(CborBase::TypeIndefinite) == NULL,
+           offsetArena.simple(CborBase::TypeUnknown) == NULL);
+
+    printf("\r\n===============================================================================\r\n");
+}
+
+/*
+    Test 32: traversal edge cases.
+*/
+void test32()
+{
+    printf("Test 32: Traversal edge cases:\r\n");
+
+    // [[], {}]
+    uint8_t empty[] = { 0x82, 0x80, 0xA0 };
+    Cborg top(empty, sizeof(empty));
+
+    printf("Empty: length: %u, array: %u/%" PRIu32 ", map: %u/%" PRIu32 "\r\n",
+           (unsigned) top.getCBORLength(),
+           (unsigned) top.at(0).getCBORLength(), top.at(0).getSize(),
+           (unsigned) top.at(1).getCBORLength(), top.at(1).getSize());
+    printf("Inside empty: %s\r\n",
+           ((top.at(0).at(0).getCBORLength() == 0) && (top.at(1).find("a").getCBORLength() == 0)) ? "none" : "found");
+
+    top.print();
+
+    // [_ 1, 2]
+    uint8_t indefinite[] = { 0x9F, 0x01, 0x02, 0xFF };
+    Cborg list(indefinite, sizeof(indefinite));
+    uint32_t second = 0;
+
+    list.at(1).getUnsigned(&second);
+
+    printf("Indefinite: second: %" PRIu32 ", past end: %u %u\r\n", second,
+           (unsigned) list.at(2).getCBORLength(), (unsigned) list.at(100).getCBORLength());
+
+    // [1, 2] cut after the first element, and no buffer at all
+    uint8_t truncated[] = { 0x82, 0x01, 0x02 };
+    Cborg cut(truncated, 2);
+    Cborg none(NULL, 0);
+
+    const uint8_t* pointer = NULL;
+    uint32_t length = 0;
+
+    printf("Truncated: length: %u, getCBOR: %d, at(1): %u\r\n", (unsigned) cut.getCBORLength(),
+           cut.getCBOR(&pointer, &length), (unsigned) cut.at(1).getCBORLength());
+    printf("Null: length: %u, getCBOR: %d, at(0): %u, find: %u\r\n", (unsigned) none.getCBORLength(),
+           none.getCBOR(&pointer, &length), (unsigned) none.at(0).getCBORLength(),
+           (unsigned) none.find("a").getCBORLength());
+
+    // cut heads in exact-size allocations fail without reading past them
+    const uint8_t cutHeads[][2] = { { 0x1B }, { 0x9A, 0x01 }, { 0xBB }, { 0xD9, 0x01 } };
+    const std::size_t cutLengths[] = { 1, 2, 1, 2 };
+    std::size_t failed = 0;
+
+    for (std::size_t idx = 0; idx < sizeof(cutLengths) / sizeof(cutLengths[0]); idx++)
+    {
+        uint8_t* exact = new uint8_t[cutLengths[idx]];
+        memcpy(exact, cutHeads[idx], cutLengths[idx]);
+
+        Cborg item(exact, cutLengths[idx]);
+        uint64_t value = 0;
+        std::size_t elements = 0;
+
+        for (Cborg element : item.elements())
+        {
+            elements += element.getCBORLength();
+        }
+
+        if ((item.getType() == CborBase::TypeSpecial) && (item.getTag() == CborBase::TypeUnassigned)
+            && !item.getUnsigned(&value) && (item.getSize() == 0) && (elements == 0)
+            && (item.at(0).getCBORLength() == 0) && (item.find(1).getCBORLength() == 0))
+        {
+            failed++;
+        }
+
+        delete[] exact;
+    }
+
+    printf("Cut heads: %u of %u fail\r\n", (unsigned) failed, (unsigned) (sizeof(cutLengths) / sizeof(cutLengths[0])));
+
+    printf("\r\n===============================================================================\r\n");
+}
+
+/*
+    Test 33: header table.
+*/
+void test33()
+{
+    printf("Test 33: Header table:\r\n");
+
+    // [18446744073709551615, 1], minor type 27 is followed by 8 bytes
+    uint8_t wide[] = { 0x82, 0x1B, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01 };
+    Cborg top(wide, sizeof(wide));
+
+    CborgHeader head;
+    head.decode(&wide[1]);
+
+    uint64_t first = 0;
+    uint32_t second = 0;
+
+    top.at(0).getUnsigned(&first);
+    top.at(1).getUnsigned(&second);
+
+    printf("Minor 27: header: %u, item: %u, value: %" PRIu64 ", next: %" PRIu32 ", total: %u\r\n",
+           head.getLength(), (unsigned) top.at(0).getCBORLength(), first, second, (unsigned) top.getCBORLength());
+
+    // minor types 28-30 are reserved for every major type
+    for (uint8_t minor = 28; minor <= 30; minor++)
+    {
+        std::size_t rejected = 0;
+
+        for (uint8_t major = 0; major < 8; major++)
+        {
+            uint8_t item[] = { (uint8_t) ((major << 5) | minor), 0x00 };
+            std::size_t length = 0;
+
+            if ((CborgHeader::getInfo(item[0]) & CborgHeader::InfoReserved)
+                && (CborgTraverse::validate(item, sizeof(item), &length) == CborgTraverse::StatusMalformed)
+                && (Cborg(item, sizeof(item)).getCBORLength() == 0))
+            {
+                rejected++;
+            }
+        }
+
+        printf("Minor %u: rejected %u of 8\r\n", minor, (unsigned) rejected);
+    }
+
+    printf("\r\n===============================================================================\r\n");
+}
+
+/*****************************************************************************/
+/* App start                                                                 */
+/*****************************************************************************/
+void app_start(int, char *[])
+{
+    test1();
+    test2();
+    test3();
+    test4();
+
+    test5();
+
+    test6();
+    test7();
+    test8();
+
+    test9();
+    test10();
+    test11();
+    test12();
+    test13();
+    test14();
+    test15();
+    test16();
+    test17();
+    test18();
+    test19();
+    test20();
+    test21();
+    test22();
+    test23();
+    test24();
+    test25();
+    test26();
+    test27();
+    test28();
+    test29();
+    test30();
+    test31();
+    test32();
+    test33();
 }
 
 /*****************************************************************************/